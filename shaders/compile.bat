@@ -1,2 +1,4 @@
 start "glslc" "C:/VulkanSDK/1.3.296.0/Bin/glslc.exe" main.vert -o compiled/main_vert.spv
-start "glslc" "C:/VulkanSDK/1.3.296.0/Bin/glslc.exe" main.frag -o compiled/main_frag.spv
\ No newline at end of file
+start "glslc" "C:/VulkanSDK/1.3.296.0/Bin/glslc.exe" main.frag -o compiled/main_frag.spv
+start "glslc" "C:/VulkanSDK/1.3.296.0/Bin/glslc.exe" main_instanced.vert -o compiled/main_instanced_vert.spv
+start "glslc" "C:/VulkanSDK/1.3.296.0/Bin/glslc.exe" main_packed.vert -o compiled/main_packed_vert.spv
\ No newline at end of file
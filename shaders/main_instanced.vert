@@ -0,0 +1,22 @@
+#version 450
+
+// one record per sprite, drawn as a 4 vertex triangle strip
+layout(location = 0) in vec2 inPos;
+layout(location = 1) in vec2 inSize;
+layout(location = 2) in vec4 inUvRect;
+layout(location = 3) in int inTextureIndex;
+layout(location = 4) in int inInteraction;
+
+layout (location = 0) out vec2 outTexCoord;
+layout(location = 1) flat out int outTexIndex;
+layout(location = 2) flat out int outInteraction;
+
+void main(void) {
+	// same corner order as the quad vertices: top left, bottom left, top right, bottom right
+	vec2 corner = vec2(gl_VertexIndex >> 1, gl_VertexIndex & 1);
+
+	gl_Position = vec4(inPos + corner * inSize, 0.0, 1.0);
+	outTexCoord = mix(inUvRect.xy, inUvRect.zw, corner);
+    outTexIndex = inTextureIndex;
+	outInteraction = inInteraction;
+}
@@ -0,0 +1,18 @@
+#version 450
+
+// PackedVertex: half float position and unorm tex coords are expanded by the vertex fetch,
+// texIndex (low 16 bits) and interaction (high 16 bits) share one uint
+layout(location = 0) in vec2 inPos;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in uint inTexIndexInteraction;
+
+layout (location = 0) out vec2 outTexCoord;
+layout(location = 1) flat out int outTexIndex;
+layout(location = 2) flat out int outInteraction;
+
+void main(void) {
+	gl_Position = vec4(inPos, 0.0, 1.0);
+	outTexCoord = inTexCoord;
+    outTexIndex = int(inTexIndexInteraction & 0xFFFFu);
+	outInteraction = int(inTexIndexInteraction >> 16);
+}
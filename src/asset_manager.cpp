@@ -3,13 +3,14 @@
 /*
 -----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
 */
-void AssetManager::init(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue) {
+void AssetManager::init(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue, const std::string& pixelCachePath) {
     log(name_ + __func__, "initializing asset manager");
 
     physicalDevice_ = physicalDevice;
     device_ = device;
     commandPool_ = commandPool;
     graphicsQueue_ = graphicsQueue;
+    pixelCachePath_ = pixelCachePath;
 
     // iterate through resource directory, grabbing all image and audio files
 	enumerateFiles();
@@ -41,12 +42,181 @@ void AssetManager::enumerateFiles() {
 }
 
 void AssetManager::initTextures() {
-	log(name_ + __func__, "creating textures");
-	for (int i = 0; i < textureFilenames_.size(); i++) {
-		Texture t;
-		t.create(textureFilenames_[i], physicalDevice_, device_, commandPool_, graphicsQueue_);
-		textures_.push_back(t);
+	int textureCount = static_cast<int>(textureFilenames_.size());
+	int threadCount = std::clamp(static_cast<int>(std::thread::hardware_concurrency()), 1, std::max(textureCount, 1));
+	log(name_ + __func__, "packing " + std::to_string(textureCount) + " images into an atlas, decoding on " + std::to_string(threadCount) + " threads");
+
+	std::vector<int> widths(textureCount, 0);
+	std::vector<int> heights(textureCount, 0);
+	std::vector<DecodedImage> decoded(textureCount);
+	std::deque<int> ready{};
+	std::mutex readyMutex;
+	std::condition_variable readyChanged;
+
+	// hits come out of the mapped file already padded and skip stb_image altogether
+	PixelCache cache;
+	cache.open(pixelCachePath_, ATLAS_PADDING, ATLAS_ALIGNMENT);
+	std::vector<char> cached(textureCount, false);
+
+	// the atlas footprint of an image side, same rounding as Texture::pad()
+	auto paddedSize = [](int size) { return (size + 2 * ATLAS_PADDING + ATLAS_ALIGNMENT - 1) / ATLAS_ALIGNMENT * ATLAS_ALIGNMENT; };
+
+	auto markReady = [&](int index) {
+		{
+			std::lock_guard<std::mutex> lock(readyMutex);
+			ready.push_back(index);
+		}
+		readyChanged.notify_one();
+	};
+
+	// decoding fans out, uploads stay on this thread (queue access) and start as soon as an image is ready.
+	// declared after the state the tasks use, so an exception joins the workers before that state goes
+	WorkerPool decoders;
+	decoders.init(threadCount);
+
+	// sizes first, they are all the packer needs: from the cache, or the header on a miss
+	for (int i = 0; i < textureCount; i++) {
+		decoders.submit([&, i]() {
+			if (cache.find(textureFilenames_[i], decoded[i])) {
+				cached[i] = true;
+				widths[i] = decoded[i].sourceWidth;
+				heights[i] = decoded[i].sourceHeight;
+			}
+			else {
+				Texture::readSize(textureFilenames_[i], widths[i], heights[i]);
+			}
+		});
+	}
+	decoders.wait();
+
+	// decode (and pad) the misses while packing and page creation run here
+	int hits = 0;
+	for (int i = 0; i < textureCount; i++) {
+		if (cached[i]) {
+			hits++;
+			markReady(i);
+			continue;
+		}
+		decoders.submit([&, i]() {
+			// a failed decode is still handed over, or the upload loop would wait for it forever
+			try {
+				decoded[i] = Texture::pad(Texture::decode(textureFilenames_[i]), ATLAS_PADDING, ATLAS_ALIGNMENT);
+				cache.add(textureFilenames_[i], decoded[i]);
+			}
+			catch (...) {
+				markReady(i);
+				throw;
+			}
+			markReady(i);
+		});
+	}
+	log(name_ + __func__, std::to_string(hits) + " of " + std::to_string(textureCount) + " images came from the pixel cache");
+
+	// PACKING ------------------------------====<
+	VkPhysicalDeviceProperties properties{};
+	vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+	// a whole number of alignment blocks, so every mip level of a page halves exactly
+	int pageSize = std::min(ATLAS_PAGE_SIZE, static_cast<int>(properties.limits.maxImageDimension2D)) / ATLAS_ALIGNMENT * ATLAS_ALIGNMENT;
+
+	// tallest first packs a skyline tightest
+	std::vector<int> order(textureCount);
+	for (int i = 0; i < textureCount; i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return heights[a] > heights[b]; });
+
+	std::vector<AtlasPacker> pages{};
+	std::vector<glm::ivec2> offsets(textureCount);
+	regions_.assign(textureCount, {});
+
+	for (int i : order) {
+		// aligned sizes keep every packed position aligned too
+		int paddedWidth = paddedSize(widths[i]);
+		int paddedHeight = paddedSize(heights[i]);
+
+		int page = -1;
+		for (size_t p = 0; p < pages.size() && page < 0; p++) {
+			if (pages[p].pack(paddedWidth, paddedHeight, offsets[i].x, offsets[i].y)) {
+				page = static_cast<int>(p);
+			}
+		}
+
+		// new page, sized to the image if it is bigger than a normal one
+		if (page < 0) {
+			if (paddedWidth > static_cast<int>(properties.limits.maxImageDimension2D) || paddedHeight > static_cast<int>(properties.limits.maxImageDimension2D)) {
+				throw std::runtime_error("image is larger than the biggest texture the device supports: " + textureFilenames_[i]);
+			}
+			AtlasPacker packer;
+			packer.init(std::max(pageSize, paddedWidth), std::max(pageSize, paddedHeight));
+			packer.pack(paddedWidth, paddedHeight, offsets[i].x, offsets[i].y);
+			pages.push_back(packer);
+			page = static_cast<int>(pages.size()) - 1;
+		}
+
+		regions_[i].page = page;
+	}
+
+	// pages only as tall as what landed on them
+	VkDeviceSize stagingSize = 0;
+	textures_.resize(pages.size());
+	for (size_t p = 0; p < pages.size(); p++) {
+		textures_[p].create("atlas page " + std::to_string(p), pages[p].getWidth(), pages[p].getUsedHeight(), ATLAS_MIP_LEVELS, physicalDevice_, device_);
+	}
+
+	for (int i = 0; i < textureCount; i++) {
+		const AtlasPacker& page = pages[regions_[i].page];
+		float pageWidth = static_cast<float>(page.getWidth());
+		float pageHeight = static_cast<float>(page.getUsedHeight());
+		float x = static_cast<float>(offsets[i].x + ATLAS_PADDING);
+		float y = static_cast<float>(offsets[i].y + ATLAS_PADDING);
+		regions_[i].uvRect = { x / pageWidth, y / pageHeight, (x + widths[i]) / pageWidth, (y + heights[i]) / pageHeight };
+
+		stagingSize += UploadBatcher::getStagingSize(paddedSize(widths[i]), paddedSize(heights[i]));
+	}
+
+	log(name_ + __func__, std::to_string(textureCount) + " images on " + std::to_string(pages.size()) + " atlas pages");
+
+	// UPLOAD ------------------------------====<
+	UploadBatcher uploads;
+	uploads.begin(stagingSize, physicalDevice_, device_, commandPool_, graphicsQueue_);
+	for (const Texture& page : textures_) {
+		uploads.addTarget(page.getImage(), page.getWidth(), page.getHeight(), page.getMipLevels());
 	}
+
+	for (int uploaded = 0; uploaded < textureCount; uploaded++) {
+		int index;
+		{
+			std::unique_lock<std::mutex> lock(readyMutex);
+			readyChanged.wait(lock, [&]() { return !ready.empty(); });
+			index = ready.front();
+			ready.pop_front();
+		}
+
+		if (!decoded[index].pixels) {
+			// rethrows the decode error
+			decoders.wait();
+		}
+
+		// header and pixels have to agree, the atlas space was sized from the header
+		if (decoded[index].sourceWidth != widths[index] || decoded[index].sourceHeight != heights[index] ||
+			decoded[index].width != paddedSize(widths[index]) || decoded[index].height != paddedSize(heights[index])) {
+			throw std::runtime_error("decoded size does not match the header of " + textureFilenames_[index]);
+		}
+
+		// the padding goes in too, the region's uvs start inside it. a cache hit is copied straight out of the mapping
+		uploads.addImage(textures_[regions_[index].page].getImage(), decoded[index], offsets[index].x, offsets[index].y);
+		decoded[index].pixels.reset();
+	}
+
+	decoders.wait();
+	decoders.cleanup();
+
+	// one submit and one fence wait for every page, mip chains included
+	uploads.submit();
+
+	// only rewritten when something was decoded or went stale, a warm start leaves the file alone
+	cache.write();
+	cache.close();
 }
 
 void AssetManager::initAudio() {
@@ -78,14 +248,17 @@ void AssetManager::initAudio() {
 /*
 -----~~~~~=====<<<<<{_GETTERS_}>>>>>=====~~~~~-----
 */
-int AssetManager::getTextureCount() { return static_cast<int>(textures_.size()); }
-const VkImageView& AssetManager::getTextureImageView(int index) const { return textures_[index].getImageView(); }
-const VkSampler& AssetManager::getTextureImageSampler(int index) const { return textures_[index].getSampler(); }
+int AssetManager::getPageCount() const { return static_cast<int>(textures_.size()); }
+const VkImageView& AssetManager::getPageImageView(int page) const { return textures_[page].getImageView(); }
+const VkSampler& AssetManager::getPageSampler(int page) const { return textures_[page].getSampler(); }
+
+int AssetManager::getRegionCount() const { return static_cast<int>(regions_.size()); }
+const TextureRegion& AssetManager::getTextureRegion(int index) const { return regions_[index]; }
 
-int AssetManager::getTextureIndex(const std::string& filename) {
+const TextureRegion& AssetManager::getTextureRegion(const std::string& filename) const {
 	for (int i = 0; i < textureFilenames_.size(); i++) {
 		if (filename == textureFilenames_[i]) {
-			return i;
+			return regions_[i];
 		}
 	}
 	throw std::runtime_error("failed to find texture: " + filename);
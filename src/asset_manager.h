@@ -5,26 +5,34 @@
 
 #include <vector>
 #include <filesystem>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 #include "util.h"
 #include "texture.h"
+#include "worker_pool.h"
+#include "upload_batcher.h"
+#include "atlas_packer.h"
+#include "pixel_cache.h"
 
 namespace fs = std::filesystem;
 
 class AssetManager {
 public:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
-	void init(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue);
+	// pixelCachePath is where decoded pixels are kept between runs, empty = always decode
+	void init(VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue, const std::string& pixelCachePath);
 
-	// get total amount of textures
-	int getTextureCount();
+	// atlas pages, each is one texture / descriptor
+	int getPageCount() const;
+	const VkImageView& getPageImageView(int page) const;
+	const VkSampler& getPageSampler(int page) const;
 
-	// by index in textures_ vector
-	const VkImageView& getTextureImageView(int index) const;
-	const VkSampler& getTextureImageSampler(int index) const;
-
-	// texture index by filename
-	int getTextureIndex(const std::string& filename);
+	// one region per image file, in enumeration order
+	int getRegionCount() const;
+	const TextureRegion& getTextureRegion(int index) const;
+	const TextureRegion& getTextureRegion(const std::string& filename) const;
 
 	// play audio sound
 	void playSound(const std::string& filename);
@@ -37,6 +45,7 @@ public:
 private:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
 	void enumerateFiles();
+	// decodes every image the pixel cache misses in parallel and packs them into atlas pages, uploaded in one batch
 	void initTextures();
 	void initAudio();
 
@@ -47,9 +56,11 @@ private:
 	VkCommandPool commandPool_ = VK_NULL_HANDLE;
 	VkQueue graphicsQueue_ = VK_NULL_HANDLE;
 
-	// Textures (int is the texture index)
+	// Textures: one per atlas page, regions_[i] is where textureFilenames_[i] ended up
 	std::vector<std::string> textureFilenames_{};
+	std::vector<TextureRegion> regions_{};
 	std::vector<Texture> textures_{};
+	std::string pixelCachePath_{};
 
 	// Audio
 	std::vector<std::string> audioFilenames_{};
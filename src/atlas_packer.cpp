@@ -0,0 +1,104 @@
+#include "atlas_packer.h"
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void AtlasPacker::init(int width, int height) {
+	width_ = width;
+	height_ = height;
+	usedHeight_ = 0;
+
+	// flat and empty
+	skyline_.clear();
+	skyline_.push_back({ 0, 0, width });
+}
+
+/*
+-----~~~~~=====<<<<<{_PACKING_}>>>>>=====~~~~~-----
+*/
+bool AtlasPacker::pack(int width, int height, int& x, int& y) {
+	int bestIndex = -1;
+	int bestTop = height_ + 1;
+	int bestWidth = width_ + 1;
+	int bestY = 0;
+
+	// lowest top edge wins, the narrower node breaks ties so wide gaps stay open
+	for (size_t i = 0; i < skyline_.size(); i++) {
+		int fitY;
+		if (!fit(i, width, height, fitY)) {
+			continue;
+		}
+		int top = fitY + height;
+		if (top < bestTop || (top == bestTop && skyline_[i].width < bestWidth)) {
+			bestIndex = static_cast<int>(i);
+			bestTop = top;
+			bestWidth = skyline_[i].width;
+			bestY = fitY;
+		}
+	}
+
+	if (bestIndex < 0) {
+		return false;
+	}
+
+	x = skyline_[bestIndex].x;
+	y = bestY;
+	place(bestIndex, x, y, width, height);
+	return true;
+}
+
+bool AtlasPacker::fit(size_t index, int width, int height, int& y) const {
+	if (skyline_[index].x + width > width_) {
+		return false;
+	}
+
+	// the rectangle rests on the highest node it spans
+	y = 0;
+	int remaining = width;
+	for (size_t i = index; remaining > 0; i++) {
+		y = std::max(y, skyline_[i].y);
+		if (y + height > height_) {
+			return false;
+		}
+		remaining -= skyline_[i].width;
+	}
+	return true;
+}
+
+void AtlasPacker::place(size_t index, int x, int y, int width, int height) {
+	skyline_.insert(skyline_.begin() + index, { x, y + height, width });
+
+	// nodes now under the new one shrink from the left or go
+	size_t next = index + 1;
+	while (next < skyline_.size()) {
+		int covered = skyline_[index].x + skyline_[index].width - skyline_[next].x;
+		if (covered <= 0) {
+			break;
+		}
+		if (covered < skyline_[next].width) {
+			skyline_[next].x += covered;
+			skyline_[next].width -= covered;
+			break;
+		}
+		skyline_.erase(skyline_.begin() + next);
+	}
+
+	// neighbours at the same height become one node
+	for (size_t i = 0; i + 1 < skyline_.size();) {
+		if (skyline_[i].y == skyline_[i + 1].y) {
+			skyline_[i].width += skyline_[i + 1].width;
+			skyline_.erase(skyline_.begin() + i + 1);
+		}
+		else {
+			i++;
+		}
+	}
+
+	usedHeight_ = std::max(usedHeight_, y + height);
+}
+
+/*
+-----~~~~~=====<<<<<{_GETTERS_}>>>>>=====~~~~~-----
+*/
+int AtlasPacker::getWidth() const { return width_; }
+int AtlasPacker::getUsedHeight() const { return usedHeight_; }
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+// skyline bottom-left rectangle packer for one atlas page. the skyline is the top edge of
+// everything placed so far, a new rectangle goes where it ends up lowest
+class AtlasPacker {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void init(int width, int height);
+
+	// finds room for a width x height rectangle, false when the page is full
+	bool pack(int width, int height, int& x, int& y);
+
+	int getWidth() const;
+	// rows actually used, the page image only needs to be this tall
+	int getUsedHeight() const;
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "AtlasPacker::";
+
+private:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// lowest y a rectangle starting at skyline node index can sit at, false if it does not fit
+	bool fit(size_t index, int width, int height, int& y) const;
+	void place(size_t index, int x, int y, int width, int height);
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	struct SkylineNode {
+		int x;
+		int y;
+		int width;
+	};
+
+	int width_ = 0;
+	int height_ = 0;
+	int usedHeight_ = 0;
+	// left to right, covering the whole page width
+	std::vector<SkylineNode> skyline_{};
+};
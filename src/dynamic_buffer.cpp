@@ -0,0 +1,83 @@
+#include "dynamic_buffer.h"
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void DynamicBuffer::create(VkDeviceSize capacity, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkDevice device, VkPhysicalDevice physicalDevice,
+	std::optional<uint32_t> memoryTypeIndex) {
+	device_ = device;
+	physicalDevice_ = physicalDevice;
+	usage_ = usage;
+	properties_ = properties;
+	memoryTypeIndex_ = memoryTypeIndex;
+
+	allocate(capacity);
+}
+
+void DynamicBuffer::allocate(VkDeviceSize capacity) {
+	createBuffer(capacity, usage_, properties_, buffer_, memory_, device_, physicalDevice_, memoryTypeIndex_);
+	capacity_ = capacity;
+	mapped_ = nullptr;
+
+	if (properties_ & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		if (vkMapMemory(device_, memory_, 0, VK_WHOLE_SIZE, 0, &mapped_) != VK_SUCCESS) {
+			throw std::runtime_error("failed to map dynamic buffer memory!");
+		}
+	}
+}
+
+/*
+-----~~~~~=====<<<<<{_GROWTH_}>>>>>=====~~~~~-----
+*/
+bool DynamicBuffer::reserve(VkDeviceSize size, const std::function<void(VkBuffer, VkDeviceMemory)>& retire) {
+	if (size <= capacity_) {
+		return false;
+	}
+
+	// double until it fits so a slowly growing scene reallocates only log(n) times
+	VkDeviceSize newCapacity = std::max<VkDeviceSize>(capacity_, 1);
+	while (newCapacity < size) {
+		newCapacity *= 2;
+	}
+
+	log(name_ + __func__, "growing buffer from " + std::to_string(capacity_) + " to " + std::to_string(newCapacity) + " bytes");
+
+	VkBuffer oldBuffer = buffer_;
+	VkDeviceMemory oldMemory = memory_;
+	void* oldMapped = mapped_;
+	VkDeviceSize oldCapacity = capacity_;
+
+	allocate(newCapacity);
+
+	// keep what was already written, so dirty tracking stays valid
+	if (oldMapped != nullptr) {
+		memcpy(mapped_, oldMapped, static_cast<size_t>(oldCapacity));
+		vkUnmapMemory(device_, oldMemory);
+	}
+
+	retire(oldBuffer, oldMemory);
+
+	return true;
+}
+
+/*
+-----~~~~~=====<<<<<{_GETTERS_}>>>>>=====~~~~~-----
+*/
+const VkBuffer& DynamicBuffer::getBuffer() const { return buffer_; }
+void* DynamicBuffer::getMapped() const { return mapped_; }
+VkDeviceSize DynamicBuffer::getCapacity() const { return capacity_; }
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void DynamicBuffer::destroy() {
+	if (mapped_ != nullptr) {
+		vkUnmapMemory(device_, memory_);
+		mapped_ = nullptr;
+	}
+	vkDestroyBuffer(device_, buffer_, nullptr);
+	vkFreeMemory(device_, memory_, nullptr);
+	buffer_ = VK_NULL_HANDLE;
+	memory_ = VK_NULL_HANDLE;
+	capacity_ = 0;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <string>
+
+#include "util.h"
+
+// GPU buffer that grows geometrically when more room is needed.
+// host visible buffers stay mapped and keep their contents across a grow
+class DynamicBuffer {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// memoryTypeIndex pins every allocation (growth included) to one memory type, otherwise the first one with properties is used
+	void create(VkDeviceSize capacity, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkDevice device, VkPhysicalDevice physicalDevice,
+		std::optional<uint32_t> memoryTypeIndex = std::nullopt);
+
+	// makes room for at least size bytes. the replaced buffer is handed to retire() because
+	// frames in flight may still read it, returns true if the buffer was reallocated
+	bool reserve(VkDeviceSize size, const std::function<void(VkBuffer, VkDeviceMemory)>& retire);
+
+	const VkBuffer& getBuffer() const;
+	void* getMapped() const;
+	VkDeviceSize getCapacity() const;
+
+	void destroy();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "DynamicBuffer::";
+
+private:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void allocate(VkDeviceSize capacity);
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	// references to vk stuff
+	VkDevice device_ = VK_NULL_HANDLE;
+	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
+
+	VkBufferUsageFlags usage_ = 0;
+	VkMemoryPropertyFlags properties_ = 0;
+	std::optional<uint32_t> memoryTypeIndex_{};
+
+	VkBuffer buffer_ = VK_NULL_HANDLE;
+	VkDeviceMemory memory_ = VK_NULL_HANDLE;
+	void* mapped_ = nullptr;
+	VkDeviceSize capacity_ = 0;
+};
@@ -3,11 +3,18 @@
 /*
 -----~~~~~=====<<<<<{_ONLY_PUBLIC_METHOD_}>>>>>=====~~~~~-----
 */
-void Engine::run() {
+void Engine::run(const EngineConfig& config) {
     log(name_ + __func__, "running engine");
 
+    config_ = config;
+    framesInFlight_ = static_cast<uint32_t>(config_.framesInFlight);
+    presentPolicy_ = config_.presentPolicy;
+
     init();
     mainLoop();
+    if (config_.benchThousands > 0) {
+        writeBenchReport();
+    }
     cleanup();
 }
 
@@ -25,15 +32,25 @@ void Engine::init() {
     initSDL();
     initVulkan();
 
+    frameLimiter_.init(config_.targetFps);
+
     // init gamestate
     state_.currentScreen = MENU;
     state_.extent = swapChainExtent_;
     state_.initialized = true;
     state_.spriteScale = 1.f;
-    state_.wireframeTextureIndex = assetManager_.getTextureIndex("../res/img/png/green.png");
+    state_.wireframeTexture = assetManager_.getTextureRegion("../res/img/png/green.png");
 
     // init renderables
     renderableManager_.init(state_, assetManager_);
+    // every change goes into each frame's buffer, or is copied into the one device local buffer once
+    renderableManager_.setDirtyTargets(spriteMemory_ == SPRITE_MEMORY_STAGED ? 1 : static_cast<int>(framesInFlight_));
+    if (config_.benchThousands > 0) {
+        renderableManager_.generateBenchScene(config_.benchThousands * 1000, config_.benchSeed);
+    }
+
+    // scene is complete, start ticking
+    simulation_.init(config_, renderableManager_);
 
     // init simulation time delta
     auto simStartTime = std::chrono::high_resolution_clock::now();
@@ -46,73 +63,173 @@ void Engine::init() {
 void Engine::mainLoop() {
     log(name_ + __func__, "executing engine main loop");
 
+    uint64_t framesRun = 0;
+
     running_ = true;
     while (running_) {
-        auto startTime = std::chrono::high_resolution_clock::now();
-	    float frameStart = std::chrono::duration<float, std::chrono::seconds::period>(startTime - state_.programStartTime).count();
- 
-        handleEvents();
+        auto frameStart = std::chrono::steady_clock::now();
+        auto stageStart = frameStart;
+
+        if (!config_.lateInput) {
+            handleEvents();
+            stageStart = timeStage(STAGE_EVENTS, stageStart);
+        }
         waitForFrame();
+        stageStart = timeStage(STAGE_WAIT, stageStart);
+        // late latch, input that arrived during the wait still makes this frame
+        if (config_.lateInput) {
+            handleEvents();
+            stageStart = timeStage(STAGE_EVENTS, stageStart);
+        }
         stepSimulation();
+        stageStart = timeStage(STAGE_SIMULATION, stageStart);
         updateBuffers();
+        stageStart = timeStage(STAGE_BUFFERS, stageStart);
 
         if (visible_) {
             // render stuff
             renderWorld();
         }
-        
-        // FIXME slow it down
-        //std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        //std::cout << "------------FRAME-----------------\n";
-        auto endTime = std::chrono::high_resolution_clock::now();
-	    float frameEnd = std::chrono::duration<float, std::chrono::seconds::period>(endTime - state_.programStartTime).count();
-
-        fpsTime_ += frameEnd - frameStart;
+        stageStart = timeStage(STAGE_RENDER, stageStart);
+
+        // sleep off the rest of the frame if there is a cap
+        frameLimiter_.wait();
+        timeStage(STAGE_LIMITER, stageStart);
+
+        timeStage(STAGE_FRAME, frameStart);
         loopsMeasured_++;
 
-        if (loopsMeasured_ > FPS_MEASURE_INTERVAL) {
-            float fps = 1 / (fpsTime_ / FPS_MEASURE_INTERVAL);
-            log(name_ + __func__, "FPS: " + std::to_string(fps));
-            fpsTime_ = 0.f;
-            loopsMeasured_ = 0;
+        if (loopsMeasured_ >= FPS_MEASURE_INTERVAL) {
+            reportFrameStats();
+        }
+
+        // fixed length runs (--frames)
+        framesRun++;
+        if (config_.frameCount > 0 && framesRun >= config_.frameCount) {
+            log(name_ + __func__, "ran " + std::to_string(framesRun) + " frames, stopping");
+            running_ = false;
         }
-    
     }
 
     vkDeviceWaitIdle(device_);
 }
 
+void Engine::writeBenchReport() {
+    log(name_ + __func__, "writing bench report to " + config_.benchReport);
+
+    std::ofstream file(config_.benchReport);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open bench report file: " + config_.benchReport);
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+
+    uint64_t frames = std::max<uint64_t>(benchStageTimes_[STAGE_FRAME].getCount(), 1);
+
+    // percentiles of one histogram as a JSON object, milliseconds
+    auto percentiles = [](const Histogram& histogram) {
+        std::stringstream output;
+        output.setf(std::ios::fixed);
+        output.precision(4);
+        output << "{ \"p50\": " << histogram.getPercentile(0.50) / 1000.0
+            << ", \"p90\": " << histogram.getPercentile(0.90) / 1000.0
+            << ", \"p99\": " << histogram.getPercentile(0.99) / 1000.0
+            << ", \"max\": " << histogram.getMax() / 1000.0 << " }";
+        return output.str();
+    };
+
+    file << "{\n";
+    // driver strings may hold quotes or backslashes
+    file << "  \"device\": \"" << escapeJson(properties.deviceName) << "\",\n";
+    file << "  \"seed\": " << config_.benchSeed << ",\n";
+    file << "  \"sprites\": " << renderableManager_.getVertexCount() / 4 << ",\n";
+    file << "  \"frames\": " << benchStageTimes_[STAGE_FRAME].getCount() << ",\n";
+    file << "  \"options\": { \"instanced\": " << (config_.instancedSprites ? "true" : "false")
+        << ", \"packed_vertices\": " << (config_.packedVertices ? "true" : "false")
+        << ", \"device_local\": " << (config_.deviceLocalVertices ? "true" : "false")
+        << ", \"headless\": " << (config_.headless ? "true" : "false")
+        << ", \"frames_in_flight\": " << framesInFlight_
+        << ", \"fps_cap\": " << config_.targetFps << " },\n";
+    file << "  \"vertices_uploaded\": { \"total\": " << benchVerticesUploaded_
+        << ", \"per_frame\": " << benchVerticesUploaded_ / frames << " },\n";
+    file << "  \"draw_calls\": { \"total\": " << benchDrawCalls_
+        << ", \"per_frame\": " << static_cast<double>(benchDrawCalls_) / frames << " },\n";
+
+    file << "  \"cpu_ms\": {\n";
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        file << "    \"" << FRAME_STAGE_NAMES[stage] << "\": " << percentiles(benchStageTimes_[stage])
+            << (stage + 1 < STAGE_COUNT ? ",\n" : "\n");
+    }
+    file << "  },\n";
+
+    file << "  \"gpu_ms\": {\n";
+    for (int stage = 0; stage < GPU_STAGE_COUNT && timestampsSupported_; stage++) {
+        file << "    \"" << GPU_STAGE_NAMES[stage] << "\": " << percentiles(benchGpuStageTimes_[stage])
+            << (stage + 1 < GPU_STAGE_COUNT ? ",\n" : "\n");
+    }
+    file << "  }\n";
+    file << "}\n";
+}
+
 void Engine::cleanup() {
     log(name_ + __func__, "cleaning up engine");
 
+    // waits on the swapchain, has to stop before it goes
+    presentWaiter_.cleanup();
+
+    // so do the last presents, the idle device says nothing about them
+    if (!presentFences_.empty()) {
+        vkWaitForFences(device_, static_cast<uint32_t>(presentFences_.size()), presentFences_.data(), VK_TRUE, UINT64_MAX);
+    }
+
     // swapchain
     cleanupVkSwapchain();
 
+    log(name_ + __func__, "cleaning up simulation");
+    simulation_.cleanup();
+
+    if (config_.recordThreads > 0) {
+        log(name_ + __func__, "stopping recording threads");
+        recordWorkers_.cleanup();
+    }
+
     log(name_ + __func__, "cleaning up renderable manager");
     renderableManager_.cleanup();
 
     log(name_ + __func__, "cleaning up asset manager");
     assetManager_.cleanup();
 
+    // anything retired during the last frames (device is idle by now)
+    log(name_ + __func__, "flushing deletion queue");
+    flushDeletionQueue(true);
+
     // buffers
-    // vertex buffer
-    log(name_ + __func__, "destroying vertex buffer");
-    vkDestroyBuffer(device_, vertexBuffer_, nullptr);
-    vkFreeMemory(device_, vertexBufferMemory_, nullptr);
+    // vertex buffers
+    log(name_ + __func__, "destroying vertex buffers");
+    for (size_t i = 0; i < framesInFlight_; i++) {
+        vertexBuffers_[i].destroy();
+    }
+    if (spriteMemory_ == SPRITE_MEMORY_STAGED) {
+        deviceVertexBuffer_.destroy();
+    }
 
     //index
     log(name_ + __func__, "destroying index buffer");
     vkDestroyBuffer(device_, indexBuffer_, nullptr);
     vkFreeMemory(device_, indexBufferMemory_, nullptr);
+    // staging nobody recorded a copy from
+    vkDestroyBuffer(device_, indexStagingBuffer_, nullptr);
+    vkFreeMemory(device_, indexStagingBufferMemory_, nullptr);
 
     // line vertex
     log(name_ + __func__, "destroying line vertex buffer");
-    vkDestroyBuffer(device_, lineVertexBuffer_, nullptr);
-    vkFreeMemory(device_, lineVertexBufferMemory_, nullptr);
+    lineVertexBuffer_.destroy();
 
     // pipeline 
     log(name_ + __func__, "destroying graphics pipeline");
     vkDestroyPipeline(device_, graphicsPipeline_, nullptr);
+    vkDestroyPipeline(device_, spritePipeline_, nullptr);
     log(name_ + __func__, "destroying pipeline layout");
     vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
     log(name_ + __func__, "destroying pipeline cache");
@@ -138,21 +255,35 @@ void Engine::cleanup() {
 
     // snyc stuff
     log(name_ + __func__, "destroying semaphores and fences");
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (size_t i = 0; i < framesInFlight_; i++) {
         vkDestroySemaphore(device_, renderFinishedSemaphores_[i], nullptr);
         vkDestroySemaphore(device_, imageAvailableSemaphores_[i], nullptr);
-        vkDestroyFence(device_, inFlightFences_[i], nullptr);
+    }
+    vkDestroySemaphore(device_, frameTimeline_, nullptr);
+    for (VkFence fence : presentFences_) {
+        vkDestroyFence(device_, fence, nullptr);
+    }
+
+    for (VkQueryPool queryPool : queryPools_) {
+        vkDestroyQueryPool(device_, queryPool, nullptr);
     }
 
     log(name_ + __func__, "destroying command pool");
+    for (std::vector<VkCommandPool>& pools : secondaryCommandPools_) {
+        for (VkCommandPool pool : pools) {
+            vkDestroyCommandPool(device_, pool, nullptr);
+        }
+    }
     vkDestroyCommandPool(device_, commandPool_, nullptr);
 
     // Devices/instance
     log(name_ + __func__, "destroying logical device");
     vkDestroyDevice(device_, nullptr);
 
-    log(name_ + __func__, "destroying surface");
-    vkDestroySurfaceKHR(instance_, surface_, nullptr);
+    if (surface_ != VK_NULL_HANDLE) {
+        log(name_ + __func__, "destroying surface");
+        vkDestroySurfaceKHR(instance_, surface_, nullptr);
+    }
 
     if (enableValidationLayers) {
         log(name_ + __func__, "destroying debug messenger");
@@ -167,7 +298,9 @@ void Engine::cleanup() {
 
     // SDL
     log(name_ + __func__, "cleaning up SDL");
-    SDL_DestroyWindow(windowPtr_);
+    if (windowPtr_ != nullptr) {
+        SDL_DestroyWindow(windowPtr_);
+    }
     SDL_Quit();
 }
 
@@ -177,6 +310,16 @@ void Engine::cleanup() {
 void Engine::initSDL() {
     log(name_ + __func__, "initializing SDL");
 
+    if (config_.headless) {
+        // no display, and bench hosts often have no sound card either
+        SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy");
+        if (!SDL_Init(SDL_INIT_EVENTS | SDL_INIT_AUDIO)) {
+            throw std::runtime_error("failed to initialize SDL");
+        }
+        log(name_ + __func__, "headless, not creating a window");
+        return;
+    }
+
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
         throw std::runtime_error("failed to initialize SDL");
     }
@@ -229,16 +372,26 @@ void Engine::initVulkan() {
     createVkDevice();
     createVkCommandBuffers();
     // creates the textures
-    assetManager_.init(physicalDevice_, device_, commandPool_, graphicsQueue_);
+    assetManager_.init(physicalDevice_, device_, commandPool_, graphicsQueue_, config_.pixelCache);
     createVkRenderPass();
-    createVkSwapchain();
+    if (config_.headless) {
+        createVkOffscreenTargets();
+    }
+    else {
+        createVkSwapchain();
+    }
     createVkDescriptors();
     createVkGraphicsPipeline();
     createVkSyncObjects();
+    createVkQueryPools();
     createVkUniformBuffers();
 
     // loading external stuff -----------------------------==================<
     vkCmdSetPolygonModeEXT = reinterpret_cast<PFN_vkCmdSetPolygonModeEXT>(vkGetDeviceProcAddr(device_, "vkCmdSetPolygonModeEXT"));
+    if (presentWaitSupported_) {
+        vkWaitForPresentKHR = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device_, "vkWaitForPresentKHR"));
+        presentWaiter_.init(device_, vkWaitForPresentKHR, swapChain_);
+    }
 }
 
 void Engine::createVkDevice() {
@@ -278,12 +431,25 @@ void Engine::createVkDevice() {
     instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     instanceCreateInfo.pApplicationInfo = &appInfo;
 
-    // get extensions (SDL):
+    // get extensions (SDL), headless needs no surface extensions
     std::vector<const char*> extensions;
-    uint32_t sdl_extension_count = 0;
-    const char* const* sdl_extensions = SDL_Vulkan_GetInstanceExtensions(&sdl_extension_count);
-    for (uint32_t i = 0; i < sdl_extension_count; i++) {
-        extensions.push_back(sdl_extensions[i]);
+    if (!config_.headless) {
+        uint32_t sdl_extension_count = 0;
+        const char* const* sdl_extensions = SDL_Vulkan_GetInstanceExtensions(&sdl_extension_count);
+        for (uint32_t i = 0; i < sdl_extension_count; i++) {
+            extensions.push_back(sdl_extensions[i]);
+        }
+    }
+
+    // present fences need surface_maintenance1 on the instance, the device side is checked once there is a device
+    swapchainMaintenanceSupported_ = !config_.headless && checkInstanceExtensionSupport(swapchainMaintenanceInstanceExtensions);
+    if (swapchainMaintenanceSupported_) {
+        for (const char* extension : swapchainMaintenanceInstanceExtensions) {
+            bool enabled = std::any_of(extensions.begin(), extensions.end(), [extension](const char* name) { return strcmp(name, extension) == 0; });
+            if (!enabled) {
+                extensions.push_back(extension);
+            }
+        }
     }
 
     if (enableValidationLayers) {
@@ -334,10 +500,14 @@ void Engine::createVkDevice() {
     }
 
     // Vulkan/SDL surface --------------------====<
-    log(name_ + __func__, "creating SDL/Vulkan window surface");
-    if (!SDL_Vulkan_CreateSurface(windowPtr_, instance_, nullptr, &surface_)) {
-        throw std::runtime_error("failed to create SDL window surface!");
+    // headless leaves surface_ null, device selection then skips the present checks
+    if (!config_.headless) {
+        log(name_ + __func__, "creating SDL/Vulkan window surface");
+        if (!SDL_Vulkan_CreateSurface(windowPtr_, instance_, nullptr, &surface_)) {
+            throw std::runtime_error("failed to create SDL window surface!");
+        }
     }
+    const std::vector<const char*>& requiredExtensions = config_.headless ? headlessDeviceExtensions : deviceExtensions;
 
     // TODO: print device selected to logger!!!!
     // Vulkan physical device (GPU) --------------------====<
@@ -352,7 +522,7 @@ void Engine::createVkDevice() {
     vkEnumeratePhysicalDevices(instance_, &deviceCount, devices.data());
 
     for (const auto& device : devices) {
-        if (isDeviceSuitable(device, surface_, deviceExtensions)) {
+        if (isDeviceSuitable(device, surface_, requiredExtensions)) {
             log(name_ + __func__, "selected vulkan physical device");
             physicalDevice_ = device;
             break;
@@ -382,16 +552,34 @@ void Engine::createVkDevice() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // optional present id/wait, only chained in when the device has the extensions
+    std::vector<const char*> enabledExtensions = requiredExtensions;
+    presentWaitSupported_ = !config_.headless && checkDeviceExtensionSupport(physicalDevice_, presentWaitDeviceExtensions);
+
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    presentIdFeatures.pNext = &presentWaitFeatures;
+
     VkPhysicalDeviceExtendedDynamicState3FeaturesEXT dynamicState3Features = {};
     dynamicState3Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT;
+    dynamicState3Features.pNext = presentWaitSupported_ ? &presentIdFeatures : nullptr;
 
     VkPhysicalDeviceVulkan12Features vulkan12Features = {};
     vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
     vulkan12Features.pNext = &dynamicState3Features;
 
+    swapchainMaintenanceSupported_ = swapchainMaintenanceSupported_ && checkDeviceExtensionSupport(physicalDevice_, swapchainMaintenanceDeviceExtensions);
+
+    VkPhysicalDeviceSwapchainMaintenance1FeaturesEXT swapchainMaintenanceFeatures = {};
+    swapchainMaintenanceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SWAPCHAIN_MAINTENANCE_1_FEATURES_EXT;
+    swapchainMaintenanceFeatures.pNext = &vulkan12Features;
+
     VkPhysicalDeviceFeatures2 physicalFeatures2 = {};
     physicalFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
-    physicalFeatures2.pNext = &vulkan12Features;
+    physicalFeatures2.pNext = swapchainMaintenanceSupported_ ? static_cast<void*>(&swapchainMaintenanceFeatures) : &vulkan12Features;
 
     vkGetPhysicalDeviceFeatures2(physicalDevice_, &physicalFeatures2);
 
@@ -399,6 +587,31 @@ void Engine::createVkDevice() {
     if (vulkan12Features.runtimeDescriptorArray && vulkan12Features.shaderSampledImageArrayNonUniformIndexing && dynamicState3Features.extendedDynamicState3PolygonMode == VK_FALSE) {
         throw std::runtime_error("needed features not enabled on chosen device");
     }
+    // frame pacing runs on a timeline semaphore (core in 1.2, enabled through the queried features)
+    if (vulkan12Features.timelineSemaphore == VK_FALSE) {
+        throw std::runtime_error("timeline semaphores not supported on chosen device");
+    }
+
+    // extensions alone are not enough, the features have to be there too
+    presentWaitSupported_ = presentWaitSupported_ && presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+    if (presentWaitSupported_) {
+        enabledExtensions.insert(enabledExtensions.end(), presentWaitDeviceExtensions.begin(), presentWaitDeviceExtensions.end());
+    }
+    else {
+        dynamicState3Features.pNext = nullptr;
+        log(name_ + __func__, "no present_id/present_wait, input to present latency not measured");
+    }
+
+    swapchainMaintenanceSupported_ = swapchainMaintenanceSupported_ && swapchainMaintenanceFeatures.swapchainMaintenance1;
+    if (swapchainMaintenanceSupported_) {
+        enabledExtensions.insert(enabledExtensions.end(), swapchainMaintenanceDeviceExtensions.begin(), swapchainMaintenanceDeviceExtensions.end());
+    }
+    else {
+        physicalFeatures2.pNext = &vulkan12Features;
+        if (!config_.headless) {
+            log(name_ + __func__, "no swapchain_maintenance1, retired swapchains are kept for an extra round of images");
+        }
+    }
 
     VkDeviceCreateInfo deviceCreateInfo{};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -406,8 +619,8 @@ void Engine::createVkDevice() {
     deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
     deviceCreateInfo.pNext = &physicalFeatures2;
     deviceCreateInfo.pEnabledFeatures = NULL;
-    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     if (enableValidationLayers) {
         deviceCreateInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -439,7 +652,7 @@ void Engine::createVkCommandBuffers() {
         throw std::runtime_error("failed to create graphics command pool!");
     }
 
-    commandBuffers_.resize(MAX_FRAMES_IN_FLIGHT);
+    commandBuffers_.resize(framesInFlight_);
 
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -451,23 +664,66 @@ void Engine::createVkCommandBuffers() {
     if (vkAllocateCommandBuffers(device_, &allocInfo, commandBuffers_.data()) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate command buffers!");
     }
+
+    // secondary command buffers for parallel recording -----------------====<
+    if (config_.recordThreads <= 0) {
+        return;
+    }
+
+    log(name_ + __func__, "creating secondary command pools for " + std::to_string(config_.recordThreads) + " recording threads");
+    recordWorkers_.init(config_.recordThreads);
+    secondaryCommandPools_.resize(framesInFlight_);
+    secondaryCommandBuffers_.resize(framesInFlight_);
+
+    // pools are reset whole every frame, so no per buffer reset flag
+    VkCommandPoolCreateInfo secondaryPoolInfo{};
+    secondaryPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    secondaryPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    secondaryPoolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+
+    // one per sprite partition, plus one the main thread records the lines into meanwhile
+    for (size_t frame = 0; frame < framesInFlight_; frame++) {
+        secondaryCommandPools_[frame].resize(config_.recordThreads + 1);
+        secondaryCommandBuffers_[frame].resize(config_.recordThreads + 1);
+
+        for (int partition = 0; partition <= config_.recordThreads; partition++) {
+            if (vkCreateCommandPool(device_, &secondaryPoolInfo, nullptr, &secondaryCommandPools_[frame][partition]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create secondary command pool!");
+            }
+
+            VkCommandBufferAllocateInfo secondaryAllocInfo{};
+            secondaryAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            secondaryAllocInfo.commandPool = secondaryCommandPools_[frame][partition];
+            secondaryAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            secondaryAllocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device_, &secondaryAllocInfo, &secondaryCommandBuffers_[frame][partition]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate secondary command buffers!");
+            }
+        }
+    }
 }
 
 void Engine::createVkRenderPass() {
     log(name_ + __func__, "creating renderpass");
 
-    // get some swapchain details here:
-    SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice_, surface_);
-
     VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = chooseSwapSurfaceFormat(swapChainSupport.formats).format;
+    if (config_.headless) {
+        colorAttachment.format = OFFSCREEN_COLOR_FORMAT;
+    }
+    else {
+        // get some swapchain details here:
+        SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice_, surface_);
+        colorAttachment.format = chooseSwapSurfaceFormat(swapChainSupport.formats).format;
+    }
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
     colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // offscreen targets are never presented, they stay attachments (and could be copied out from there)
+    colorAttachment.finalLayout = config_.headless ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = findDepthFormat(physicalDevice_);
@@ -526,7 +782,8 @@ void Engine::createVkSwapchain() {
     log(name_ + __func__, "creating swapchain");
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice_, surface_);
     VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
-    VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+    presentMode_ = chooseSwapPresentMode(swapChainSupport.presentModes, presentPolicy_);
+    log(name_ + __func__, std::string("present policy ") + PRESENT_POLICY_NAMES[presentPolicy_] + " -> " + getPresentModeName(presentMode_));
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities, windowPtr_);
 
     uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -560,8 +817,10 @@ void Engine::createVkSwapchain() {
 
     swapCreateInfo.preTransform = swapChainSupport.capabilities.currentTransform;
     swapCreateInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    swapCreateInfo.presentMode = presentMode;
+    swapCreateInfo.presentMode = presentMode_;
     swapCreateInfo.clipped = VK_TRUE;
+    // null on the first call, on a recreate the driver can hand over resources and images still queued for present
+    swapCreateInfo.oldSwapchain = swapChain_;
 
     if (vkCreateSwapchainKHR(device_, &swapCreateInfo, nullptr, &swapChain_) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
@@ -587,6 +846,10 @@ void Engine::createVkSwapchain() {
         );
     }
 
+    createVkFramebuffers();
+}
+
+void Engine::createVkFramebuffers() {
     // DEPTH RESOURCES --------------------================<
     log(name_ + __func__, "creating depth resources");
     VkFormat depthFormat = findDepthFormat(physicalDevice_);
@@ -633,33 +896,97 @@ void Engine::createVkSwapchain() {
     }
 }
 
+void Engine::createVkOffscreenTargets() {
+    log(name_ + __func__, "creating offscreen render targets");
+
+    // one color target per frame in flight, in place of swapchain images
+    swapChainImageFormat_ = OFFSCREEN_COLOR_FORMAT;
+    swapChainExtent_ = { WIDTH, HEIGHT };
+    swapChainImages_.resize(framesInFlight_);
+    offscreenImageMemory_.resize(framesInFlight_);
+    swapChainImageViews_.resize(framesInFlight_);
+
+    for (uint32_t i = 0; i < framesInFlight_; i++) {
+        createImage(
+            swapChainExtent_.width,
+            swapChainExtent_.height,
+            swapChainImageFormat_,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            swapChainImages_[i],
+            offscreenImageMemory_[i],
+            device_,
+            physicalDevice_
+        );
+
+        swapChainImageViews_[i] = createImageView(
+            swapChainImages_[i],
+            swapChainImageFormat_,
+            VK_IMAGE_ASPECT_COLOR_BIT,
+            device_
+        );
+    }
+
+    createVkFramebuffers();
+}
+
 void Engine::createVkDescriptors() {
     log(name_ + __func__, "creating descriptor stuff");
-    // Vertex buffer --------------------------------------------=========<
-    log(name_ + __func__, "creating vertex buffer");
-    VkDeviceSize vertexBufferSize = MAX_QUADS * sizeof(Vertex) * 4;
-    createBuffer(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        vertexBuffer_, vertexBufferMemory_, device_, physicalDevice_);
+    // Vertex buffers --------------------------------------------=========<
+    // one per frame in flight so the CPU never writes vertices the GPU is still reading,
+    // each stays mapped and grows in updateBuffers() when the scene outgrows it
+    log(name_ + __func__, "creating vertex buffers");
+    VkDeviceSize vertexBufferSize = INITIAL_QUAD_CAPACITY * getSpriteSize();
+    vertexBuffers_.resize(framesInFlight_);
+    indexCounts_.assign(framesInFlight_, 0);
+    instanceCounts_.assign(framesInFlight_, 0);
+
+    VkBufferUsageFlags ringUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    VkMemoryPropertyFlags ringProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    // the large BAR heap's type, set only with resizable BAR
+    std::optional<uint32_t> ringMemoryType{};
+
+    if (config_.deviceLocalVertices) {
+        ringMemoryType = findResizableBarMemoryType(physicalDevice_);
+        if (ringMemoryType.has_value()) {
+            // the CPU can write video memory directly, no copy needed
+            spriteMemory_ = SPRITE_MEMORY_REBAR;
+            ringProperties |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            log(name_ + __func__, "resizable BAR found, vertex buffers are device local and mapped");
+        }
+        else {
+            // the ring only stages, the GPU reads a single device local copy
+            spriteMemory_ = SPRITE_MEMORY_STAGED;
+            ringUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            deviceVertexBuffer_.create(vertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, device_, physicalDevice_);
+            log(name_ + __func__, "no resizable BAR, vertex buffers are device local and staged");
+        }
+    }
+
+    for (size_t i = 0; i < framesInFlight_; i++) {
+        vertexBuffers_[i].create(vertexBufferSize, ringUsage, ringProperties, device_, physicalDevice_, ringMemoryType);
+    }
 
     // Index buffer --------------------------------------------=========<
-    log(name_ + __func__, "creating index buffer");
-    VkDeviceSize indexBufferSize = MAX_QUADS * sizeof(uint32_t) * 6;
-    createBuffer(indexBufferSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        indexBuffer_, indexBufferMemory_, device_, physicalDevice_);
+    // instanced sprites expand their quads in the vertex shader and need no indices
+    if (!config_.instancedSprites) {
+        createVkQuadIndexBuffer(INITIAL_QUAD_CAPACITY);
+    }
 
     // LINE buffers 
     // vertex
     log(name_ + __func__, "creating line buffer");
-    VkDeviceSize lineVertexBufferSize = MAX_LINES * sizeof(Vertex) * 2;
-    createBuffer(lineVertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+    VkDeviceSize lineVertexBufferSize = INITIAL_LINE_CAPACITY * sizeof(Vertex) * 2;
+    lineVertexBuffer_.create(lineVertexBufferSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        lineVertexBuffer_, lineVertexBufferMemory_, device_, physicalDevice_);
+        device_, physicalDevice_);
 
     // Descriptor ------------------------------------------=============<
     log(name_ + __func__, "creating descriptor pool");
-    int textureCount = assetManager_.getTextureCount();
+    // one combined image sampler per atlas page
+    int textureCount = assetManager_.getPageCount();
     std::array<VkDescriptorPoolSize, 1> poolSizes{};
     poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     poolSizes[0].descriptorCount = textureCount;
@@ -708,8 +1035,8 @@ void Engine::createVkDescriptors() {
     std::vector<VkDescriptorImageInfo> textureDescriptors(textureCount);
     for (int i = 0; i < textureCount; i++) {
         textureDescriptors[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        textureDescriptors[i].imageView = assetManager_.getTextureImageView(i);
-        textureDescriptors[i].sampler = assetManager_.getTextureImageSampler(i);
+        textureDescriptors[i].imageView = assetManager_.getPageImageView(i);
+        textureDescriptors[i].sampler = assetManager_.getPageSampler(i);
     }
 
     std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
@@ -723,27 +1050,57 @@ void Engine::createVkDescriptors() {
     vkUpdateDescriptorSets(device_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
-void Engine::createVkGraphicsPipeline() {
-    log(name_ + __func__, "creating graphics pipeline");
+void Engine::createVkQuadIndexBuffer(uint32_t quadCapacity) {
+    log(name_ + __func__, "creating index buffer for " + std::to_string(quadCapacity) + " quads");
 
-    VkShaderModule vertShaderModule = createShaderModule("../shaders/compiled/main_vert.spv", device_);
-    VkShaderModule fragShaderModule = createShaderModule("../shaders/compiled/main_frag.spv", device_);
+    // the quad pattern never changes, so it is only regenerated when the quad capacity grows
+    std::vector<uint16_t> shortIndices;
+    std::vector<uint32_t> longIndices;
+    const void* indexData = nullptr;
+    VkDeviceSize indexBufferSize = 0;
 
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
+    if (quadCapacity * 4 <= std::numeric_limits<uint16_t>::max() + 1) {
+        shortIndices = generateQuadIndices<uint16_t>(quadCapacity);
+        indexData = shortIndices.data();
+        indexBufferSize = shortIndices.size() * sizeof(uint16_t);
+        indexType_ = VK_INDEX_TYPE_UINT16;
+    }
+    else {
+        longIndices = generateQuadIndices<uint32_t>(quadCapacity);
+        indexData = longIndices.data();
+        indexBufferSize = longIndices.size() * sizeof(uint32_t);
+        indexType_ = VK_INDEX_TYPE_UINT32;
+    }
 
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
+    // a staging copy that never got recorded (no frame drawn since the last growth) is simply replaced
+    if (indexStagingBuffer_ != VK_NULL_HANDLE) {
+        VkBuffer oldStaging = indexStagingBuffer_;
+        VkDeviceMemory oldStagingMemory = indexStagingBufferMemory_;
+        deferDeletion([this, oldStaging, oldStagingMemory]() {
+            vkDestroyBuffer(device_, oldStaging, nullptr);
+            vkFreeMemory(device_, oldStagingMemory, nullptr);
+        });
+    }
 
-    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-    shaderStages.push_back(vertShaderStageInfo);
-    shaderStages.push_back(fragShaderStageInfo);
+    createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        indexStagingBuffer_, indexStagingBufferMemory_, device_, physicalDevice_);
+
+    void* data;
+    vkMapMemory(device_, indexStagingBufferMemory_, 0, indexBufferSize, 0, &data);
+    memcpy(data, indexData, static_cast<size_t>(indexBufferSize));
+    vkUnmapMemory(device_, indexStagingBufferMemory_);
+
+    createBuffer(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBuffer_, indexBufferMemory_, device_, physicalDevice_);
+
+    // copied by the next recorded frame (recordIndexUpload), no queue wait here
+    indexStagingSize_ = indexBufferSize;
+    indexQuadCapacity_ = quadCapacity;
+}
+
+void Engine::createVkGraphicsPipeline() {
+    log(name_ + __func__, "creating graphics pipeline");
 
     // Pipeline cache
     VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
@@ -762,6 +1119,69 @@ void Engine::createVkGraphicsPipeline() {
         throw std::runtime_error("failed to create pipeline layout!");
     }
 
+    // quad and line pipeline, fed by Vertex
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    auto bindingDescription = Vertex::getBindingDescription();
+    auto attributeDescriptions = Vertex::getAttributeDescriptions();
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
+
+    graphicsPipeline_ = createVkPipeline("../shaders/compiled/main_vert.spv", vertexInputInfo);
+
+    // sprite pipeline, only needed when sprites are not plain Vertex data
+    // instanced: fed by one SpriteInstance per quad
+    if (config_.instancedSprites) {
+        log(name_ + __func__, "creating instanced sprite pipeline");
+        VkPipelineVertexInputStateCreateInfo instanceInputInfo{};
+        instanceInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        auto instanceBindingDescription = SpriteInstance::getBindingDescription();
+        auto instanceAttributeDescriptions = SpriteInstance::getAttributeDescriptions();
+        instanceInputInfo.vertexBindingDescriptionCount = 1;
+        instanceInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(instanceAttributeDescriptions.size());
+        instanceInputInfo.pVertexBindingDescriptions = &instanceBindingDescription;
+        instanceInputInfo.pVertexAttributeDescriptions = instanceAttributeDescriptions.data();
+
+        spritePipeline_ = createVkPipeline("../shaders/compiled/main_instanced_vert.spv", instanceInputInfo);
+    }
+    // packed: fed by PackedVertex
+    else if (config_.packedVertices) {
+        log(name_ + __func__, "creating packed vertex sprite pipeline");
+        VkPipelineVertexInputStateCreateInfo packedInputInfo{};
+        packedInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+        auto packedBindingDescription = Vertex::getBindingDescription(VERTEX_FORMAT_PACKED);
+        auto packedAttributeDescriptions = Vertex::getAttributeDescriptions(VERTEX_FORMAT_PACKED);
+        packedInputInfo.vertexBindingDescriptionCount = 1;
+        packedInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(packedAttributeDescriptions.size());
+        packedInputInfo.pVertexBindingDescriptions = &packedBindingDescription;
+        packedInputInfo.pVertexAttributeDescriptions = packedAttributeDescriptions.data();
+
+        spritePipeline_ = createVkPipeline("../shaders/compiled/main_packed_vert.spv", packedInputInfo);
+    }
+}
+
+VkPipeline Engine::createVkPipeline(const std::string& vertShaderFilename, const VkPipelineVertexInputStateCreateInfo& vertexInputInfo) {
+    VkShaderModule vertShaderModule = createShaderModule(vertShaderFilename, device_);
+    VkShaderModule fragShaderModule = createShaderModule("../shaders/compiled/main_frag.spv", device_);
+
+    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageInfo.module = vertShaderModule;
+    vertShaderStageInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageInfo.module = fragShaderModule;
+    fragShaderStageInfo.pName = "main";
+
+    std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+    shaderStages.push_back(vertShaderStageInfo);
+    shaderStages.push_back(fragShaderStageInfo);
+
     // Enable blending, using alpha from red channel of the font texture (see text.frag)
     VkPipelineColorBlendAttachmentState blendAttachmentState{};
     blendAttachmentState.blendEnable = VK_TRUE;
@@ -825,15 +1245,6 @@ void Engine::createVkGraphicsPipeline() {
     dynamicState.pDynamicStates = dynamicStateEnables.data();
 
 
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    auto bindingDescription = Vertex::getBindingDescription();
-    auto attributeDescriptions = Vertex::getAttributeDescriptions();
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
-
     VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
     pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineCreateInfo.layout = pipelineLayout_;
@@ -849,32 +1260,102 @@ void Engine::createVkGraphicsPipeline() {
     pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
     pipelineCreateInfo.pStages = shaderStages.data();
 
-    if (vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline_) != VK_SUCCESS) {
+    VkPipeline pipeline;
+    if (vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &pipelineCreateInfo, nullptr, &pipeline) != VK_SUCCESS) {
         throw std::runtime_error("failed to create graphics pipeline!");
     }
 
     vkDestroyShaderModule(device_, fragShaderModule, nullptr);
     vkDestroyShaderModule(device_, vertShaderModule, nullptr);
+
+    return pipeline;
 }
 
 void Engine::createVkSyncObjects() {
     log(name_ + __func__, "creating vulkan sync objects");
-    imageAvailableSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
+    imageAvailableSemaphores_.resize(framesInFlight_);
+    renderFinishedSemaphores_.resize(framesInFlight_);
+    frameTimelineValues_.assign(framesInFlight_, 0);
 
+    // acquire and present only take binary semaphores
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
+    for (size_t i = 0; i < framesInFlight_; i++) {
+        if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &imageAvailableSemaphores_[i]) != VK_SUCCESS ||
+            vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &renderFinishedSemaphores_[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create synchronization objects for a frame!");
+        }
+    }
+
+    // one timeline for all frames replaces the per frame fences
+    VkSemaphoreTypeCreateInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo timelineSemaphoreInfo{};
+    timelineSemaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    timelineSemaphoreInfo.pNext = &timelineInfo;
+
+    if (vkCreateSemaphore(device_, &timelineSemaphoreInfo, nullptr, &frameTimeline_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create frame timeline semaphore!");
+    }
+
+    if (swapchainMaintenanceSupported_) {
+        createVkPresentFences();
+    }
+
+    log(name_ + __func__, std::to_string(framesInFlight_) + " frames in flight");
+}
+
+void Engine::createVkPresentFences() {
+    presentFences_.resize(framesInFlight_);
+
+    // signaled, so the first present from each frame in flight has nothing to wait for
     VkFenceCreateInfo fenceInfo{};
     fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &imageAvailableSemaphores_[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &renderFinishedSemaphores_[i]) != VK_SUCCESS ||
-            vkCreateFence(device_, &fenceInfo, nullptr, &inFlightFences_[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create synchronization objects for a frame!");
+    for (size_t i = 0; i < framesInFlight_; i++) {
+        if (vkCreateFence(device_, &fenceInfo, nullptr, &presentFences_[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create present fence!");
+        }
+    }
+}
+
+void Engine::createVkQueryPools() {
+    log(name_ + __func__, "creating timestamp query pools");
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+    timestampPeriod_ = properties.limits.timestampPeriod;
+
+    // the graphics queue has to support timestamps for any of this to work
+    QueueFamilyIndices indices = findQueueFamilies(physicalDevice_, surface_);
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, queueFamilies.data());
+
+    uint32_t validBits = queueFamilies[indices.graphicsFamily.value()].timestampValidBits;
+    timestampsSupported_ = validBits > 0;
+    if (!timestampsSupported_) {
+        log(name_ + __func__, "graphics queue has no timestamp support, GPU timings disabled");
+        return;
+    }
+    timestampMask_ = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = GPU_TIMESTAMP_COUNT;
+
+    queryPools_.resize(framesInFlight_);
+    queriesWritten_.assign(framesInFlight_, false);
+    for (size_t i = 0; i < framesInFlight_; i++) {
+        if (vkCreateQueryPool(device_, &queryPoolInfo, nullptr, &queryPools_[i]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timestamp query pool!");
         }
     }
 }
@@ -884,6 +1365,49 @@ void Engine::createVkUniformBuffers() {
     log(name_ + __func__, "FYI: these are not being created this function is EMPTY");
 }
 
+// bytes one sprite takes up in a vertex buffer with the configured layout
+VkDeviceSize Engine::getSpriteSize() const {
+    if (config_.instancedSprites) {
+        return sizeof(SpriteInstance);
+    }
+    return 4 * (config_.packedVertices ? sizeof(PackedVertex) : sizeof(Vertex));
+}
+
+/*
+-----~~~~~=====<<<<<{_DEFERRED_DELETION_}>>>>>=====~~~~~-----
+*/
+void Engine::deferDeletion(std::function<void()> destroy, uint64_t extraFrames, std::vector<VkFence> presentFences) {
+    // the frame being recorded may still reference the object, its submit signals frameNumber_ + 1
+    uint64_t timelineValue = frameNumber_ + 1 + extraFrames;
+    // kept in signal order, so the flush can stop at the first entry that is not free yet
+    auto position = std::upper_bound(deletionQueue_.begin(), deletionQueue_.end(), timelineValue,
+        [](uint64_t value, const PendingDeletion& pending) { return value < pending.timelineValue; });
+    deletionQueue_.insert(position, PendingDeletion{ timelineValue, std::move(destroy), std::move(presentFences) });
+}
+
+void Engine::flushDeletionQueue(bool all) {
+    // the timeline only moves forward and the queue is sorted by it
+    uint64_t completed = 0;
+    vkGetSemaphoreCounterValue(device_, frameTimeline_, &completed);
+
+    while (!deletionQueue_.empty()) {
+        PendingDeletion& pending = deletionQueue_.front();
+        if (!all && pending.timelineValue > completed) {
+            break;
+        }
+        // rendering being done says nothing about the present that waits on it
+        if (!pending.presentFences.empty()) {
+            uint32_t fenceCount = static_cast<uint32_t>(pending.presentFences.size());
+            uint64_t timeout = all ? UINT64_MAX : 0;
+            if (vkWaitForFences(device_, fenceCount, pending.presentFences.data(), VK_TRUE, timeout) != VK_SUCCESS) {
+                break;
+            }
+        }
+        pending.destroy();
+        deletionQueue_.pop_front();
+    }
+}
+
 /*
 -----~~~~~=====<<<<<{_SUB_MAIN_LOOP_METHODS_}>>>>>=====~~~~~-----
 */
@@ -897,6 +1421,10 @@ void Engine::handleEvents() {
             break;
         case SDL_EVENT_KEY_DOWN:
         case SDL_EVENT_KEY_UP:
+            // latency is counted from the oldest input the next frame picks up
+            if (pendingInputNs_ == 0) {
+                pendingInputNs_ = event_.key.timestamp;
+            }
             handleKeyEvent();
             break;
         }
@@ -928,18 +1456,53 @@ void Engine::handleKeyEvent() {
     case SDL_SCANCODE_LCTRL:
         state_.keys.ctrl = down;
         break;
+    // frame limit presets
+    case SDL_SCANCODE_MINUS:
+        if (down && !event_.key.repeat) frameLimiter_.cyclePreset(-1);
+        break;
+    case SDL_SCANCODE_EQUALS:
+        if (down && !event_.key.repeat) frameLimiter_.cyclePreset(1);
+        break;
+    // present policy
+    case SDL_SCANCODE_P:
+        if (down && !event_.key.repeat) cyclePresentPolicy();
+        break;
     default: break;
     }
 
-    // now do stuff?
-    renderableManager_.onKey();
+    // the simulation picks the new key state up at its next tick
+    simulation_.setKeys(state_.keys);
+}
+
+void Engine::cyclePresentPolicy() {
+    // nothing is presented headless
+    if (config_.headless) {
+        return;
+    }
+
+    // the image acquired for this frame belongs to the current swapchain, so the switch waits for its present
+    presentPolicy_ = static_cast<PresentPolicy>((presentPolicy_ + 1) % PRESENT_POLICY_COUNT);
+    log(name_ + __func__, std::string("switching to present policy ") + PRESENT_POLICY_NAMES[presentPolicy_]);
+    swapchainOutdated_ = true;
+}
+
+void Engine::collectPresentLatency() {
+    // timestamped on the waiter thread when each present was shown, only the histogram lives here
+    presentWaiter_.collect(presentLatenciesUs_);
+    for (double latencyUs : presentLatenciesUs_) {
+        latencyTimes_[LATENCY_TO_PRESENT].record(latencyUs);
+    }
 }
 
 void Engine::recreateVkSwapchain() {
     log(name_ + __func__, "recreating swapchain");
-    vkDeviceWaitIdle(device_);
-    cleanupVkSwapchain();
+    // present ids belong to the old swapchain, and the waiter lets go of it before it is retired
+    presentWaiter_.setSwapchain(VK_NULL_HANDLE);
+    swapchainOutdated_ = false;
+    // frames in flight keep rendering into the old resources, nothing waits on the GPU here
+    retireVkSwapchain();
     createVkSwapchain();
+    presentWaiter_.setSwapchain(swapChain_);
     log(name_ + __func__, "new swapchain extent: ["
         + std::to_string(swapChainExtent_.width)
         + ", "
@@ -952,78 +1515,214 @@ void Engine::recreateVkSwapchain() {
 }
 
 void Engine::waitForFrame() {
-    // wait for frame to be ready before mapping buffers?
-    vkWaitForFences(device_, 1, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+    // wait for the last submit from this frame in flight before touching its buffers
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &frameTimeline_;
+    waitInfo.pValues = &frameTimelineValues_[currentFrame_];
+    vkWaitSemaphores(device_, &waitInfo, UINT64_MAX);
+
+    // anything retired by a frame that has now finished can go
+    flushDeletionQueue(false);
+
+    // same for the timestamps that frame wrote
+    collectGpuTimestamps();
+    if (presentWaitSupported_) {
+        collectPresentLatency();
+    }
+
+    // offscreen targets go with the frame in flight and are free once its timeline value is reached
+    if (config_.headless) {
+        imageIndex_ = currentFrame_;
+        return;
+    }
 
-    VkResult result = vkAcquireNextImageKHR(device_, swapChain_, UINT64_MAX, imageAvailableSemaphores_[currentFrame_], VK_NULL_HANDLE, &imageIndex_);
+    // the present waiter shares the swapchain, it waits under the same lock
+    VkResult result;
+    {
+        std::unique_lock<std::mutex> swapchainLock = presentWaiter_.lockSwapchain();
+        result = vkAcquireNextImageKHR(device_, swapChain_, UINT64_MAX, imageAvailableSemaphores_[currentFrame_], VK_NULL_HANDLE, &imageIndex_);
+    }
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+    // nothing was acquired, so this frame takes its image from the new swapchain.
+    // a drag resize can outdate that one too before the acquire, so keep going until one sticks
+    while (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateVkSwapchain();
+        std::unique_lock<std::mutex> swapchainLock = presentWaiter_.lockSwapchain();
+        result = vkAcquireNextImageKHR(device_, swapChain_, UINT64_MAX, imageAvailableSemaphores_[currentFrame_], VK_NULL_HANDLE, &imageIndex_);
     }
-    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         throw std::runtime_error("failed to acquire swap chain image!");
     }
 }
 
 void Engine::stepSimulation() {
-    // update simulation time delta
     auto newCurrentSimulationTime = std::chrono::high_resolution_clock::now();
-    // first, update the delta using the old time
-    float currentTime = std::chrono::duration<float, std::chrono::seconds::period>(newCurrentSimulationTime - state_.programStartTime).count();
-    state_.simulationTimeDelta = currentTime - state_.currentSimulationTime;
-    // update the current sim time
-    state_.currentSimulationTime = currentTime;
-    renderableManager_.updateAll();
+    state_.currentSimulationTime = std::chrono::duration<float, std::chrono::seconds::period>(newCurrentSimulationTime - state_.programStartTime).count();
+    state_.simulationTimeDelta = static_cast<float>(1.0 / config_.simTickRate);
+
+    // fixed ticks run here unless the simulation has its own thread
+    simulation_.step();
 }
 
 void Engine::updateBuffers() {
     // update buffers here ------------------------<<<<<<<<<<<<<<<<
-    if (state_.needTriangleRemap) {
-        indexCount_ = 0;
-        int vertexCount = 0;
+    // the fence for currentFrame_ has been waited on, so its buffer is free to write.
+    // only the slots that changed since this buffer was last used get written
+    // newest simulation state, placed between its last two ticks
+    const SimSnapshot& snapshot = simulation_.acquireSnapshot();
+    state_.interpolationAlpha = simulation_.getAlpha(snapshot, SDL_GetTicksNS());
+    renderableManager_.applySnapshot(snapshot, state_.interpolationAlpha);
 
-        // triangle buffer
-        if (vkMapMemory(device_, vertexBufferMemory_, 0, VK_WHOLE_SIZE, 0, (void**)&vertexMapped_) != VK_SUCCESS) {
-            throw std::runtime_error("failed to map vertex buffer memory for overlay update ");
-        }
+    uint32_t quadCount = static_cast<uint32_t>(renderableManager_.getVertexCount() / 4);
+
+    dirtyRanges_.clear();
+
+    // staged changes are only copied when a frame is recorded, keep them queued until then
+    if (spriteMemory_ == SPRITE_MEMORY_STAGED && !visible_) {
+        return;
+    }
 
-        assert(vertexMapped_ != nullptr);
+    auto retire = [this](VkBuffer buffer, VkDeviceMemory memory) {
+        deferDeletion([this, buffer, memory]() {
+            vkDestroyBuffer(device_, buffer, nullptr);
+            vkFreeMemory(device_, memory, nullptr);
+        });
+    };
+
+    // grow this frame's buffer if the scene outgrew it, other frames grow when they come around
+    vertexBuffers_[currentFrame_].reserve(quadCount * getSpriteSize(), retire);
+
+    // the device local copy cannot be carried over on the CPU, so it is filled again from scratch
+    if (spriteMemory_ == SPRITE_MEMORY_STAGED && deviceVertexBuffer_.reserve(quadCount * getSpriteSize(), retire)) {
+        renderableManager_.markAllDirty();
+    }
+
+    // with a single device local target every frame shares one dirty list
+    uint32_t dirtyTarget = spriteMemory_ == SPRITE_MEMORY_STAGED ? 0 : currentFrame_;
 
-        vertexCount = renderableManager_.mapAll(vertexMapped_);
+    if (config_.instancedSprites) {
+        SpriteInstance* instanceMapped = static_cast<SpriteInstance*>(vertexBuffers_[currentFrame_].getMapped());
+        instanceCounts_[currentFrame_] = renderableManager_.mapDirtyInstances(instanceMapped, dirtyTarget, dirtyRanges_);
+    }
+    else {
+        // index buffer is shared by all frames, the old one is retired like a vertex buffer
+        if (quadCount > indexQuadCapacity_) {
+            VkBuffer oldBuffer = indexBuffer_;
+            VkDeviceMemory oldMemory = indexBufferMemory_;
+            deferDeletion([this, oldBuffer, oldMemory]() {
+                vkDestroyBuffer(device_, oldBuffer, nullptr);
+                vkFreeMemory(device_, oldMemory, nullptr);
+            });
+            createVkQuadIndexBuffer(std::max(quadCount, indexQuadCapacity_ * 2));
+        }
+
+        int vertexCount = 0;
+        if (config_.packedVertices) {
+            PackedVertex* packedMapped = static_cast<PackedVertex*>(vertexBuffers_[currentFrame_].getMapped());
+            vertexCount = renderableManager_.mapDirtyPacked(packedMapped, dirtyTarget, dirtyRanges_);
+        }
+        else {
+            Vertex* vertexMapped = static_cast<Vertex*>(vertexBuffers_[currentFrame_].getMapped());
+            vertexCount = renderableManager_.mapDirty(vertexMapped, dirtyTarget, dirtyRanges_);
+        }
 
         // points should be divisible by 4 no remainder
         if (vertexCount % 4 != 0) {
             throw std::runtime_error("game pointCount not divisible by 4, pointCount % 4 = " + std::to_string(vertexCount % 4));
         }
 
-        // vertex buffer
-        vkUnmapMemory(device_, vertexBufferMemory_);
-        vertexMapped_ = nullptr;
+        // index buffer is static, only the count changes
+        indexCounts_[currentFrame_] = (vertexCount / 4) * 6;
+    }
 
-        // INDEX MAPPING ---------------------------------------<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<<
+    for (const VertexRange& range : dirtyRanges_) {
+        verticesUploaded_ += range.count;
+        benchVerticesUploaded_ += range.count;
+    }
+}
 
-        // populate index buffer
-        if (vkMapMemory(device_, indexBufferMemory_, 0, VK_WHOLE_SIZE, 0, (void**)&indexMapped_) != VK_SUCCESS) {
-            throw std::runtime_error("failed to map index buffer memory for overlay update ");
-        }
+std::chrono::steady_clock::time_point Engine::timeStage(FrameStage stage, std::chrono::steady_clock::time_point start) {
+    auto now = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(now - start).count();
+    stageTimes_[stage].record(us);
+    if (config_.benchThousands > 0) {
+        benchStageTimes_[stage].record(us);
+    }
+    return now;
+}
 
-        assert(indexMapped_ != nullptr);
+void Engine::collectGpuTimestamps() {
+    if (!timestampsSupported_ || !queriesWritten_[currentFrame_]) {
+        return;
+    }
+    queriesWritten_[currentFrame_] = false;
+
+    // the timeline has passed this frame's value, so the results are there and no WAIT is needed
+    std::array<uint64_t, GPU_TIMESTAMP_COUNT> timestamps{};
+    VkResult result = vkGetQueryPoolResults(device_, queryPools_[currentFrame_], 0, GPU_TIMESTAMP_COUNT,
+        sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS) {
+        return;
+    }
 
-        std::vector<int> indices = { 0,1,2,2,1,3 };
-        for (int i = 0; i < vertexCount / 4; i++) {
-            for (int j = 0; j < indices.size(); j++) {
-                *indexMapped_ = (indices[j] + (4 * i));
-                indexMapped_++;
-                indexCount_++;
-            }
+    // counters with fewer than 64 valid bits wrap, the difference is taken modulo the valid range
+    auto toUs = [this](uint64_t begin, uint64_t end) {
+        uint64_t ticks = ((end & timestampMask_) - (begin & timestampMask_)) & timestampMask_;
+        return static_cast<double>(ticks) * timestampPeriod_ / 1000.0;
+    };
+    std::array<double, GPU_STAGE_COUNT> stageUs{};
+    stageUs[GPU_STAGE_SPRITES] = toUs(timestamps[0], timestamps[1]);
+    stageUs[GPU_STAGE_LINES] = toUs(timestamps[1], timestamps[2]);
+    stageUs[GPU_STAGE_RENDER_PASS] = toUs(timestamps[0], timestamps[3]);
+
+    for (int stage = 0; stage < GPU_STAGE_COUNT; stage++) {
+        gpuStageTimes_[stage].record(stageUs[stage]);
+        if (config_.benchThousands > 0) {
+            benchGpuStageTimes_[stage].record(stageUs[stage]);
         }
+    }
+}
+
+void Engine::reportFrameStats() {
+    // percentiles instead of a mean so single hitches and the stage causing them show up
+    const Histogram& frame = stageTimes_[STAGE_FRAME];
+    double medianFps = frame.getPercentile(0.5) > 0.0 ? 1000000.0 / frame.getPercentile(0.5) : 0.0;
+
+    std::string pacing = "";
+    if (frameLimiter_.getTargetFps() > 0.0) {
+        pacing = ", pacing error (us) mean: " + std::to_string(frameLimiter_.getErrorMean())
+            + " stddev: " + std::to_string(frameLimiter_.getErrorStdDev());
+        frameLimiter_.resetStats();
+    }
+
+    log(name_ + __func__, std::to_string(loopsMeasured_) + " frames, median FPS: " + std::to_string(medianFps)
+        + ", vertices uploaded per frame: " + std::to_string(verticesUploaded_ / loopsMeasured_)
+        + pacing);
 
-        vkUnmapMemory(device_, indexBufferMemory_);
-        indexMapped_ = nullptr;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        log(name_ + __func__, "  " + std::string(FRAME_STAGE_NAMES[stage]) + " " + stageTimes_[stage].summary());
+        stageTimes_[stage].reset();
+    }
 
-        // reset state
-        state_.needTriangleRemap = false;
+    // GPU side, lags the CPU stages by the frames in flight
+    for (int stage = 0; stage < GPU_STAGE_COUNT && timestampsSupported_; stage++) {
+        log(name_ + __func__, "  " + std::string(GPU_STAGE_NAMES[stage]) + " " + gpuStageTimes_[stage].summary());
+        gpuStageTimes_[stage].reset();
     }
+
+    // only when there was input to measure
+    for (int latency = 0; latency < LATENCY_COUNT; latency++) {
+        if (latencyTimes_[latency].getCount() > 0) {
+            log(name_ + __func__, "  " + std::string(LATENCY_NAMES[latency]) + " " + latencyTimes_[latency].summary());
+            latencyTimes_[latency].reset();
+        }
+    }
+
+    loopsMeasured_ = 0;
+    verticesUploaded_ = 0;
 }
 
 void Engine::renderWorld() {
@@ -1039,8 +1738,6 @@ VkCommandBuffer Engine::setupVkCommandBuffer() {
     // create next command buffer
     VkCommandBuffer commandBuffer = commandBuffers_[currentFrame_];
 
-    vkResetFences(device_, 1, &inFlightFences_[currentFrame_]);
-
     vkResetCommandBuffer(commandBuffer, 0);
 
     VkCommandBufferBeginInfo beginInfo{};
@@ -1050,6 +1747,18 @@ VkCommandBuffer Engine::setupVkCommandBuffer() {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
+    // resets and copies are not allowed inside a render pass
+    if (timestampsSupported_) {
+        vkCmdResetQueryPool(commandBuffer, queryPools_[currentFrame_], 0, GPU_TIMESTAMP_COUNT);
+    }
+
+    recordIndexUpload(commandBuffer);
+    if (spriteMemory_ == SPRITE_MEMORY_STAGED) {
+        recordVertexUploads(commandBuffer);
+    }
+
+    writeGpuTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = renderPass_;
@@ -1065,8 +1774,19 @@ VkCommandBuffer Engine::setupVkCommandBuffer() {
     renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
     renderPassInfo.pClearValues = clearValues.data();
 
+    // with recording threads the pass holds nothing but vkCmdExecuteCommands
+    if (config_.recordThreads > 0) {
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        return commandBuffer;
+    }
+
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    setDrawState(commandBuffer);
+
+    return commandBuffer;
+}
 
+void Engine::setDrawState(VkCommandBuffer commandBuffer) {
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
 
     VkViewport viewport{};
@@ -1086,34 +1806,221 @@ VkCommandBuffer Engine::setupVkCommandBuffer() {
     // Set polygon mode and line width
     vkCmdSetPolygonModeEXT(commandBuffer, currentPolygonMode_);
 
-    return commandBuffer;
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSet_, 0, NULL);
+}
+
+void Engine::recordIndexUpload(VkCommandBuffer commandBuffer) {
+    if (indexStagingBuffer_ == VK_NULL_HANDLE) {
+        return;
+    }
+
+    // the index buffer is new, nothing can be reading it yet
+    VkBufferCopy region{};
+    region.size = indexStagingSize_;
+    vkCmdCopyBuffer(commandBuffer, indexStagingBuffer_, indexBuffer_, 1, &region);
+
+    // this frame's draws (and every later submit) have to see the copy
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDEX_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = indexBuffer_;
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    // staging goes once this frame's submit has finished
+    VkBuffer staging = indexStagingBuffer_;
+    VkDeviceMemory stagingMemory = indexStagingBufferMemory_;
+    deferDeletion([this, staging, stagingMemory]() {
+        vkDestroyBuffer(device_, staging, nullptr);
+        vkFreeMemory(device_, stagingMemory, nullptr);
+    });
+    indexStagingBuffer_ = VK_NULL_HANDLE;
+    indexStagingBufferMemory_ = VK_NULL_HANDLE;
+    indexStagingSize_ = 0;
+}
+
+void Engine::recordVertexUploads(VkCommandBuffer commandBuffer) {
+    if (dirtyRanges_.empty()) {
+        return;
+    }
+
+    // ranges are in vertices, or in instances when instanced
+    VkDeviceSize elementSize = config_.instancedSprites ? sizeof(SpriteInstance) : getSpriteSize() / 4;
+
+    std::vector<VkBufferCopy> regions(dirtyRanges_.size());
+    for (size_t i = 0; i < dirtyRanges_.size(); i++) {
+        regions[i].srcOffset = dirtyRanges_[i].first * elementSize;
+        regions[i].dstOffset = regions[i].srcOffset;
+        regions[i].size = dirtyRanges_[i].count * elementSize;
+    }
+
+    // the previous frame may still be fetching vertices from the buffer being overwritten
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+    vkCmdCopyBuffer(commandBuffer, vertexBuffers_[currentFrame_].getBuffer(), deviceVertexBuffer_.getBuffer(),
+        static_cast<uint32_t>(regions.size()), regions.data());
+
+    // and this frame's draws have to see the copy
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = deviceVertexBuffer_.getBuffer();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 0, nullptr, 1, &barrier, 0, nullptr);
 }
 
 void Engine::drawCalls(VkCommandBuffer commandBuffer) {
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+    if (config_.recordThreads > 0) {
+        recordSecondaryDraws(commandBuffer);
+        return;
+    }
 
-    // Set polygon mode and line width
-    vkCmdSetPolygonModeEXT(commandBuffer, currentPolygonMode_);
+    uint32_t spriteCount = static_cast<uint32_t>(config_.instancedSprites ? instanceCounts_[currentFrame_] : indexCounts_[currentFrame_] / 6);
+    benchDrawCalls_ += recordSpriteDraws(commandBuffer, 0, spriteCount);
+    benchDrawCalls_ += recordLineDraws(commandBuffer, true);
+}
 
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSet_, 0, NULL);
+void Engine::recordSecondaryDraws(VkCommandBuffer commandBuffer) {
+    int partitions = config_.recordThreads;
+    uint32_t spriteCount = static_cast<uint32_t>(config_.instancedSprites ? instanceCounts_[currentFrame_] : indexCounts_[currentFrame_] / 6);
+    uint32_t perPartition = (spriteCount + partitions - 1) / partitions;
+
+    std::vector<uint32_t> drawCounts(partitions + 1, 0);
+
+    // this frame's fence was waited on, so its pools are free to reset
+    auto beginSecondary = [this](int index) {
+        VkCommandPool pool = secondaryCommandPools_[currentFrame_][index];
+        VkCommandBuffer secondary = secondaryCommandBuffers_[currentFrame_][index];
+        vkResetCommandPool(device_, pool, 0);
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass_;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = swapChainFramebuffers_[imageIndex_];
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(secondary, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        setDrawState(secondary);
+        return secondary;
+    };
+
+    auto endSecondary = [](VkCommandBuffer secondary) {
+        if (vkEndCommandBuffer(secondary) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record secondary command buffer!");
+        }
+    };
+
+    for (int partition = 0; partition < partitions; partition++) {
+        recordWorkers_.submit([this, partition, spriteCount, perPartition, &drawCounts, &beginSecondary, &endSecondary]() {
+            VkCommandBuffer secondary = beginSecondary(partition);
+
+            // contiguous slices keep the draw order, vkCmdExecuteCommands runs them in partition order
+            uint32_t first = std::min(partition * perPartition, spriteCount);
+            uint32_t count = std::min(perPartition, spriteCount - first);
+            drawCounts[partition] = recordSpriteDraws(secondary, first, count);
+
+            endSecondary(secondary);
+        });
+    }
+
+    // executed after every partition, so its first timestamp closes all of their sprite draws
+    VkCommandBuffer lines = beginSecondary(partitions);
+    drawCounts[partitions] = recordLineDraws(lines, false);
+    endSecondary(lines);
+
+    recordWorkers_.wait();
+
+    vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(partitions + 1), secondaryCommandBuffers_[currentFrame_].data());
+
+    for (uint32_t drawCount : drawCounts) {
+        benchDrawCalls_ += drawCount;
+    }
+}
+
+uint32_t Engine::recordSpriteDraws(VkCommandBuffer commandBuffer, uint32_t firstSprite, uint32_t spriteCount) {
+    uint32_t drawCount = 0;
 
     VkDeviceSize offsets = 0;
 
     // DRAW TRIANGLES
-    vkCmdSetPrimitiveTopology(commandBuffer, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer_, &offsets);
-    vkCmdBindIndexBuffer(commandBuffer, indexBuffer_, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(indexCount_), 1, 0, 0, 0);
+    // sprites get their own pipeline when they are not fed plain Vertex data, polygon mode is dynamic in both
+    if (spritePipeline_ != VK_NULL_HANDLE) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, spritePipeline_);
+    }
+
+    const VkBuffer* spriteBuffer = spriteMemory_ == SPRITE_MEMORY_STAGED ? &deviceVertexBuffer_.getBuffer() : &vertexBuffers_[currentFrame_].getBuffer();
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, spriteBuffer, &offsets);
+
+    if (spriteCount > 0 && config_.instancedSprites) {
+        // 4 vertex strip per instance, the corners come from gl_VertexIndex
+        vkCmdSetPrimitiveTopology(commandBuffer, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+        vkCmdDraw(commandBuffer, 4, spriteCount, 0, firstSprite);
+        drawCount++;
+    }
+    else if (spriteCount > 0) {
+        vkCmdSetPrimitiveTopology(commandBuffer, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+        vkCmdBindIndexBuffer(commandBuffer, indexBuffer_, 0, indexType_);
+        vkCmdDrawIndexed(commandBuffer, spriteCount * 6, 1, firstSprite * 6, 0, 0);
+        drawCount++;
+    }
+
+    return drawCount;
+}
+
+uint32_t Engine::recordLineDraws(VkCommandBuffer commandBuffer, bool afterSprites) {
+    writeGpuTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+
+    // lines are always plain Vertex data
+    if (afterSprites && spritePipeline_ != VK_NULL_HANDLE) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
+    }
 
     // DRAW LINES
+    VkDeviceSize offsets = 0;
     vkCmdSetPrimitiveTopology(commandBuffer, VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &lineVertexBuffer_, &offsets);
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &lineVertexBuffer_.getBuffer(), &offsets);
     vkCmdDraw(commandBuffer, static_cast<uint32_t>(linePointCount_), 1, 0, 0);
+
+    writeGpuTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2);
+
+    return 1;
+}
+
+void Engine::writeGpuTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, uint32_t query) {
+    if (timestampsSupported_) {
+        vkCmdWriteTimestamp(commandBuffer, stage, queryPools_[currentFrame_], query);
+    }
 }
 
 void Engine::submitVkCommandBuffer(VkCommandBuffer commandBuffer) {
     vkCmdEndRenderPass(commandBuffer);
 
+    writeGpuTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 3);
+    if (timestampsSupported_) {
+        queriesWritten_[currentFrame_] = true;
+    }
+
     if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer!");
     }
@@ -1121,29 +2028,59 @@ void Engine::submitVkCommandBuffer(VkCommandBuffer commandBuffer) {
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+    // headless has no acquire to wait on and no present to signal
+    uint32_t semaphoreCount = config_.headless ? 0 : 1;
+
     VkSemaphore waitSemaphores[] = { imageAvailableSemaphores_[currentFrame_] };
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = semaphoreCount;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
 
-    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores_[currentFrame_] };
-    submitInfo.signalSemaphoreCount = 1;
+    // the timeline always, the binary semaphore only when there is a present to wait on it
+    uint64_t timelineValue = frameNumber_ + 1;
+    VkSemaphore signalSemaphores[] = { frameTimeline_, renderFinishedSemaphores_[currentFrame_] };
+    uint64_t signalValues[] = { timelineValue, 0 };
+    submitInfo.signalSemaphoreCount = 1 + semaphoreCount;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, inFlightFences_[currentFrame_]) != VK_SUCCESS) {
+    // binary semaphores ignore their value, but every semaphore needs one
+    uint64_t waitValues[] = { 0 };
+    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+    timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineSubmitInfo.waitSemaphoreValueCount = semaphoreCount;
+    timelineSubmitInfo.pWaitSemaphoreValues = waitValues;
+    timelineSubmitInfo.signalSemaphoreValueCount = 1 + semaphoreCount;
+    timelineSubmitInfo.pSignalSemaphoreValues = signalValues;
+    submitInfo.pNext = &timelineSubmitInfo;
+
+    if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
+    frameTimelineValues_[currentFrame_] = timelineValue;
+
+    // this frame carries every input handled so far
+    uint64_t inputNs = pendingInputNs_;
+    pendingInputNs_ = 0;
+    if (inputNs != 0) {
+        latencyTimes_[LATENCY_TO_SUBMIT].record(static_cast<double>(SDL_GetTicksNS() - inputNs) / 1000.0);
+    }
+
+    if (config_.headless) {
+        currentFrame_ = (currentFrame_ + 1) % framesInFlight_;
+        frameNumber_++;
+        return;
+    }
 
     // PRESENT ----------------------------------------======================<
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.pWaitSemaphores = &renderFinishedSemaphores_[currentFrame_];
 
     VkSwapchainKHR swapChains[] = { swapChain_ };
     presentInfo.swapchainCount = 1;
@@ -1151,21 +2088,94 @@ void Engine::submitVkCommandBuffer(VkCommandBuffer commandBuffer) {
 
     presentInfo.pImageIndices = &imageIndex_;
 
-    VkResult result = vkQueuePresentKHR(presentQueue_, &presentInfo);
+    // ids only have to increase, the timeline value does
+    VkPresentIdKHR presentId{};
+    presentId.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentId.swapchainCount = 1;
+    presentId.pPresentIds = &timelineValue;
+    if (presentWaitSupported_) {
+        presentInfo.pNext = &presentId;
+    }
+
+    // signaled once this present is done with the swapchain, which is what retiring it waits for
+    VkSwapchainPresentFenceInfoEXT presentFenceInfo{};
+    presentFenceInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_PRESENT_FENCE_INFO_EXT;
+    presentFenceInfo.swapchainCount = 1;
+    if (swapchainMaintenanceSupported_) {
+        // the last present from this frame in flight went out framesInFlight_ frames ago
+        vkWaitForFences(device_, 1, &presentFences_[currentFrame_], VK_TRUE, UINT64_MAX);
+        vkResetFences(device_, 1, &presentFences_[currentFrame_]);
+        presentFenceInfo.pFences = &presentFences_[currentFrame_];
+        presentFenceInfo.pNext = presentInfo.pNext;
+        presentInfo.pNext = &presentFenceInfo;
+    }
+
+    VkResult result;
+    {
+        std::unique_lock<std::mutex> swapchainLock = presentWaiter_.lockSwapchain();
+        result = vkQueuePresentKHR(presentQueue_, &presentInfo);
+    }
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+    if (presentWaitSupported_ && inputNs != 0 && (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
+        presentWaiter_.push(timelineValue, inputNs);
+    }
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || swapchainOutdated_) {
         recreateVkSwapchain();
     }
     else if (result != VK_SUCCESS) {
         throw std::runtime_error("failed to present swap chain image!");
     }
 
-    currentFrame_ = (currentFrame_ + 1) % MAX_FRAMES_IN_FLIGHT;
+    currentFrame_ = (currentFrame_ + 1) % framesInFlight_;
+    frameNumber_++;
 }
 
 /*
 -----~~~~~=====<<<<<{_SUB_CLEANUP_METHODS_}>>>>>=====~~~~~-----
 */
+void Engine::retireVkSwapchain() {
+    log(name_ + __func__, "retiring swapchain resources");
+
+    VkSwapchainKHR oldSwapChain = swapChain_;
+    VkImage oldDepthImage = depthImage_;
+    VkDeviceMemory oldDepthImageMemory = depthImageMemory_;
+    VkImageView oldDepthImageView = depthImageView_;
+    std::vector<VkFramebuffer> oldFramebuffers = std::move(swapChainFramebuffers_);
+    std::vector<VkImageView> oldImageViews = std::move(swapChainImageViews_);
+    swapChainFramebuffers_.clear();
+    swapChainImageViews_.clear();
+
+    // the last frame recorded against these is the current one, but its timeline value only says rendering is done.
+    // with present fences they also wait for every present still out on the old swapchain (the new swapchain gets
+    // fresh fences), without them they stay until every old image could have gone round once more
+    std::vector<VkFence> oldPresentFences = std::move(presentFences_);
+    presentFences_.clear();
+    uint64_t extraFrames = 0;
+    if (swapchainMaintenanceSupported_) {
+        createVkPresentFences();
+    }
+    else {
+        extraFrames = swapChainImages_.size();
+    }
+
+    deferDeletion([this, oldSwapChain, oldDepthImage, oldDepthImageMemory, oldDepthImageView, oldFramebuffers, oldImageViews, oldPresentFences]() {
+        vkDestroyImageView(device_, oldDepthImageView, nullptr);
+        vkDestroyImage(device_, oldDepthImage, nullptr);
+        vkFreeMemory(device_, oldDepthImageMemory, nullptr);
+        for (VkFramebuffer framebuffer : oldFramebuffers) {
+            vkDestroyFramebuffer(device_, framebuffer, nullptr);
+        }
+        for (VkImageView imageView : oldImageViews) {
+            vkDestroyImageView(device_, imageView, nullptr);
+        }
+        vkDestroySwapchainKHR(device_, oldSwapChain, nullptr);
+        for (VkFence fence : oldPresentFences) {
+            vkDestroyFence(device_, fence, nullptr);
+        }
+    }, extraFrames, oldPresentFences);
+}
+
 void Engine::cleanupVkSwapchain() {
     log(name_ + __func__, "cleaning up swapchain");
 
@@ -1184,6 +2194,15 @@ void Engine::cleanupVkSwapchain() {
         vkDestroyImageView(device_, imageView, nullptr);
     }
 
+    if (config_.headless) {
+        log(name_ + __func__, "destroying offscreen images");
+        for (size_t i = 0; i < swapChainImages_.size(); i++) {
+            vkDestroyImage(device_, swapChainImages_[i], nullptr);
+            vkFreeMemory(device_, offscreenImageMemory_[i], nullptr);
+        }
+        return;
+    }
+
     log(name_ + __func__, "destroying swapchain");
     vkDestroySwapchainKHR(device_, swapChain_, nullptr);
 }
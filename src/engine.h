@@ -12,16 +12,24 @@
 #include <set>
 #include <stdexcept>
 #include <thread>
+#include <deque>
+#include <functional>
 
 // includes from project
 #include "util.h"
 #include "asset_manager.h"
+#include "dynamic_buffer.h"
+#include "frame_limiter.h"
+#include "histogram.h"
+#include "present_waiter.h"
+#include "simulation.h"
+#include "worker_pool.h"
 #include "renderables/renderable_manager.h"
 
 // main class for the whole program
 class Engine {
 public:
-    void run();
+    void run(const EngineConfig& config);
 
     const std::string name_ = "Engine::";
 private:
@@ -31,6 +39,9 @@ private:
     void mainLoop();
     void cleanup();
 
+    // --bench results, written once the run is over
+    void writeBenchReport();
+
     // init sub-functions
     void initSDL();
     void initVulkan();
@@ -40,26 +51,58 @@ private:
     void createVkCommandBuffers();
     void createVkRenderPass();
 	void createVkSwapchain();
+	void createVkOffscreenTargets(); // stands in for the swapchain with --headless
+	void createVkFramebuffers(); // depth image + one framebuffer per swapchain/offscreen image
 	void createVkDescriptors();
+	void createVkQuadIndexBuffer(uint32_t quadCapacity);
+	VkDeviceSize getSpriteSize() const;
 	void createVkGraphicsPipeline();
+	VkPipeline createVkPipeline(const std::string& vertShaderFilename, const VkPipelineVertexInputStateCreateInfo& vertexInputInfo);
 	void createVkSyncObjects();
+	void createVkPresentFences();
+	void createVkQueryPools();
 	void createVkUniformBuffers();
 
+	// deferred deletion of objects that frames in flight may still use, extraFrames after the current one finishes
+	// and once every fence in presentFences has signaled
+	void deferDeletion(std::function<void()> destroy, uint64_t extraFrames = 0, std::vector<VkFence> presentFences = {});
+	void flushDeletionQueue(bool all);
+
 	// swapchain helpers
 	void recreateVkSwapchain();
+	// hands the current swapchain resources to the deletion queue, swapChain_ stays set for oldSwapchain
+	void retireVkSwapchain();
 	void cleanupVkSwapchain();
 
     // Main loop sub-functions
     void handleEvents(); // input handling step
 	void handleKeyEvent();
+	void cyclePresentPolicy(); // next PresentPolicy, applied through a swapchain recreate after the next present
+	void collectPresentLatency(); // input to present times the present waiter measured since the last frame
 	void waitForFrame();
 	void stepSimulation();
 	void updateBuffers(); // updating buffers with new vertex data based on sim (MAYBE USE UNIFORM BUFFER INSTEAD??)
 	void renderWorld(); // makes vk command buffer, draws everything, submits command buffer
+	// records the time since start into the stage's histogram, returns now for the next stage
+	std::chrono::steady_clock::time_point timeStage(FrameStage stage, std::chrono::steady_clock::time_point start);
+	void reportFrameStats();
+	// reads back the timestamps of the frame whose fence was just waited on
+	void collectGpuTimestamps();
+	void writeGpuTimestamp(VkCommandBuffer commandBuffer, VkPipelineStageFlagBits stage, uint32_t query);
 
 	// render world sub functions
 	VkCommandBuffer setupVkCommandBuffer();
+	void recordIndexUpload(VkCommandBuffer commandBuffer); // copies a freshly grown index buffer in from staging
+	void recordVertexUploads(VkCommandBuffer commandBuffer);
 	void drawCalls(VkCommandBuffer commandBuffer);
+	// pipeline, viewport, scissor, polygon mode and descriptors, none of which secondary command buffers inherit
+	void setDrawState(VkCommandBuffer commandBuffer);
+	// sprites [firstSprite, firstSprite + spriteCount), returns the draw count
+	uint32_t recordSpriteDraws(VkCommandBuffer commandBuffer, uint32_t firstSprite, uint32_t spriteCount);
+	// the lines between the end of sprites and end of lines timestamps, afterSprites when the sprite pipeline may be bound
+	uint32_t recordLineDraws(VkCommandBuffer commandBuffer, bool afterSprites);
+	// splits the sprites over the worker pool, one secondary command buffer each, and records the lines meanwhile
+	void recordSecondaryDraws(VkCommandBuffer commandBuffer);
 	void submitVkCommandBuffer(VkCommandBuffer commandBuffer);
 
 
@@ -67,8 +110,26 @@ private:
     // state variables
     bool running_ = false;
     bool visible_ = true;
-    float fpsTime_ = 0.f;
 	int loopsMeasured_ = 0;
+	uint64_t verticesUploaded_ = 0;
+	// steady clock time of each loop stage, reported and reset every FPS_MEASURE_INTERVAL loops
+	std::array<Histogram, STAGE_COUNT> stageTimes_{};
+	std::array<Histogram, GPU_STAGE_COUNT> gpuStageTimes_{};
+	// whole run copies of the above plus totals, only filled with --bench
+	std::array<Histogram, STAGE_COUNT> benchStageTimes_{};
+	std::array<Histogram, GPU_STAGE_COUNT> benchGpuStageTimes_{};
+	uint64_t benchVerticesUploaded_ = 0;
+	uint64_t benchDrawCalls_ = 0;
+	// input latency, reported with the stages
+	std::array<Histogram, LATENCY_COUNT> latencyTimes_{};
+	// SDL_GetTicksNS time of the oldest input event no submitted frame has handled yet, 0 = none
+	uint64_t pendingInputNs_ = 0;
+
+	// options from the command line
+	EngineConfig config_{};
+
+	// main loop rate cap
+	FrameLimiter frameLimiter_;
 
 	// game state
 	GameState state_{};
@@ -79,6 +140,9 @@ private:
 	// game object manager
 	RenderableManager renderableManager_;
 
+	// fixed rate ticks and the snapshots they publish (declared after what it updates)
+	Simulation simulation_;
+
     // SDL objects
     SDL_Window* windowPtr_ = nullptr;
     SDL_Event event_;
@@ -96,13 +160,29 @@ private:
     // Vulkan command buffers --------------------===<
     VkCommandPool commandPool_ = VK_NULL_HANDLE;
 	std::vector<VkCommandBuffer> commandBuffers_{};
+	// --record-threads: [frame in flight][partition], one pool per partition so recording threads never share one
+	WorkerPool recordWorkers_;
+	std::vector<std::vector<VkCommandPool>> secondaryCommandPools_{};
+	std::vector<std::vector<VkCommandBuffer>> secondaryCommandBuffers_{};
     uint32_t currentFrame_ = 0;
+    uint32_t framesInFlight_ = DEFAULT_FRAMES_IN_FLIGHT;
 
 	// Vulkan Renderpass ------------------------==<
 	VkRenderPass renderPass_ = VK_NULL_HANDLE;
 
 	// Vulkan Swapchain -----------------------===<
 	VkSwapchainKHR swapChain_ = VK_NULL_HANDLE;
+	PresentPolicy presentPolicy_ = PRESENT_POLICY_LOW_LATENCY;
+	VkPresentModeKHR presentMode_ = VK_PRESENT_MODE_FIFO_KHR; // what the policy resolved to on this device
+	bool swapchainOutdated_ = false; // recreate after the next present
+	// VK_KHR_present_id + VK_KHR_present_wait, every present gets frameNumber_ + 1 as its id
+	bool presentWaitSupported_ = false;
+	// waits on those ids on its own thread, and owns the lock the swapchain is used under
+	PresentWaiter presentWaiter_;
+	std::vector<double> presentLatenciesUs_{};
+	// VK_EXT_swapchain_maintenance1, each frame in flight's present signals its fence once it is done with the swapchain
+	bool swapchainMaintenanceSupported_ = false;
+	std::vector<VkFence> presentFences_{};
 	std::vector<VkImage> swapChainImages_{};
 	VkFormat swapChainImageFormat_ = VK_FORMAT_UNDEFINED;
 	VkExtent2D swapChainExtent_{};
@@ -112,6 +192,8 @@ private:
 	VkDeviceMemory depthImageMemory_ = VK_NULL_HANDLE;
 	VkImageView depthImageView_ = VK_NULL_HANDLE;
 	uint32_t imageIndex_ = 0;
+	// headless render targets live in swapChainImages_, their memory here
+	std::vector<VkDeviceMemory> offscreenImageMemory_{};
 
 	// Vulkan descriptor layout/pool/sets --------------------===<
 	VkDescriptorSetLayout descriptorSetLayout_ = VK_NULL_HANDLE;
@@ -120,32 +202,60 @@ private:
 	VkDescriptorSet descriptorSet_ = VK_NULL_HANDLE;
 
 	// BUFFERS ---------------------------======<
-	// triangles
-	VkBuffer vertexBuffer_ = VK_NULL_HANDLE;
-	VkDeviceMemory vertexBufferMemory_ = VK_NULL_HANDLE;
+	// triangles (one vertex buffer per frame in flight, indexed by currentFrame_, persistently mapped)
+	// holds Vertex, PackedVertex or SpriteInstance data depending on config_
+	std::vector<DynamicBuffer> vertexBuffers_{};
+	// with SPRITE_MEMORY_STAGED the ring above is only staging and the GPU reads from this one
+	SpriteMemory spriteMemory_ = SPRITE_MEMORY_HOST;
+	DynamicBuffer deviceVertexBuffer_;
 	VkBuffer indexBuffer_ = VK_NULL_HANDLE;
 	VkDeviceMemory indexBufferMemory_ = VK_NULL_HANDLE;
+	uint32_t indexQuadCapacity_ = 0;
+	// new quad indices waiting for the next recorded frame to copy them into indexBuffer_
+	VkBuffer indexStagingBuffer_ = VK_NULL_HANDLE;
+	VkDeviceMemory indexStagingBufferMemory_ = VK_NULL_HANDLE;
+	VkDeviceSize indexStagingSize_ = 0;
 	// lines
-	VkBuffer lineVertexBuffer_ = VK_NULL_HANDLE;
-	VkDeviceMemory lineVertexBufferMemory_ = VK_NULL_HANDLE;
-
-	// memory mapped vertex buffer
-	Vertex* vertexMapped_ = nullptr;
-	uint32_t* indexMapped_ = nullptr;
-	int indexCount_ = 0;
-	Vertex* lineVertexMapped_ = nullptr;
+	DynamicBuffer lineVertexBuffer_;
+
+	std::vector<int> indexCounts_{};
+	std::vector<int> instanceCounts_{};
+	// vertex ranges written by the last remap (reused to avoid reallocating every frame)
+	std::vector<VertexRange> dirtyRanges_{};
+	// static quad index buffer lives in device local memory, 16 bit when the quad capacity allows it
+	VkIndexType indexType_ = VK_INDEX_TYPE_UINT32;
 	int linePointCount_ = 0;
 
 	// Pipeline ---------------------------======<
 	VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
 	VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
 	VkPipeline graphicsPipeline_ = VK_NULL_HANDLE;
+	VkPipeline spritePipeline_ = VK_NULL_HANDLE; // only when sprites are instanced or packed
 	VkPolygonMode currentPolygonMode_ = VK_POLYGON_MODE_FILL;
 
 	// Vulkan synchronization ------------------------===<
 	std::vector<VkSemaphore> imageAvailableSemaphores_{};
 	std::vector<VkSemaphore> renderFinishedSemaphores_{};
-	std::vector<VkFence> inFlightFences_{};
+	// signaled with frameNumber_ + 1 by each frame's submit, so its value is the number of finished frames
+	VkSemaphore frameTimeline_ = VK_NULL_HANDLE;
+	// value the last submit from each frame in flight signals, 0 = nothing submitted yet
+	std::vector<uint64_t> frameTimelineValues_{};
+	// counts submitted frames
+	uint64_t frameNumber_ = 0;
+
+	struct PendingDeletion {
+		uint64_t timelineValue; // free once frameTimeline_ reaches this
+		std::function<void()> destroy;
+		std::vector<VkFence> presentFences; // and these have signaled
+	};
+	std::deque<PendingDeletion> deletionQueue_{};
+
+	// GPU timestamps, one pool per frame in flight so results are read without waiting
+	std::vector<VkQueryPool> queryPools_{};
+	std::vector<bool> queriesWritten_{};
+	bool timestampsSupported_ = false;
+	float timestampPeriod_ = 1.f; // nanoseconds per tick
+	uint64_t timestampMask_ = UINT64_MAX; // timestampValidBits of the graphics queue, the bits above are garbage
 
 	// UBO ----------------------------------------===< DONT NEED YET
 	//std::vector<VkBuffer> uniformBuffers_{};
@@ -154,4 +264,5 @@ private:
 
 	// EXTERNAL Vulkan API function ptrs
 	PFN_vkCmdSetPolygonModeEXT vkCmdSetPolygonModeEXT{ VK_NULL_HANDLE };
+	PFN_vkWaitForPresentKHR vkWaitForPresentKHR{ VK_NULL_HANDLE };
 };
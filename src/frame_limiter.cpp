@@ -0,0 +1,91 @@
+#include "frame_limiter.h"
+
+// the last stretch before a deadline is spun instead of slept
+static const uint64_t SPIN_THRESHOLD_NS = 500'000;
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void FrameLimiter::init(double targetFps) {
+	setTargetFps(targetFps);
+}
+
+/*
+-----~~~~~=====<<<<<{_PACING_}>>>>>=====~~~~~-----
+*/
+void FrameLimiter::wait() {
+	if (periodNs_ == 0) {
+		return;
+	}
+
+	uint64_t now = SDL_GetTicksNS();
+
+	// deadlines advance by whole periods so the rate does not drift, unless the loop
+	// fell more than a frame behind, then it starts over instead of rushing to catch up
+	nextFrameNs_ += periodNs_;
+	if (nextFrameNs_ + periodNs_ < now) {
+		nextFrameNs_ = now;
+		return;
+	}
+
+	// coarse sleep
+	if (nextFrameNs_ > now + SPIN_THRESHOLD_NS) {
+		SDL_DelayNS(nextFrameNs_ - now - SPIN_THRESHOLD_NS);
+	}
+
+	// precise spin
+	do {
+		now = SDL_GetTicksNS();
+	} while (now < nextFrameNs_);
+
+	double errorUs = static_cast<double>(now - nextFrameNs_) / 1000.0;
+	errorSum_ += errorUs;
+	errorSquareSum_ += errorUs * errorUs;
+	errorCount_++;
+}
+
+void FrameLimiter::setTargetFps(double targetFps) {
+	targetFps_ = targetFps > 0.0 ? targetFps : 0.0;
+	periodNs_ = targetFps_ > 0.0 ? static_cast<uint64_t>(1'000'000'000.0 / targetFps_) : 0;
+	nextFrameNs_ = SDL_GetTicksNS();
+	resetStats();
+
+	log(name_ + __func__, targetFps_ > 0.0 ? "frame limit: " + std::to_string(targetFps_) + " fps" : "frame limit: uncapped");
+}
+
+double FrameLimiter::getTargetFps() const { return targetFps_; }
+
+void FrameLimiter::cyclePreset(int direction) {
+	int presetCount = static_cast<int>(FRAME_LIMIT_PRESETS.size());
+
+	// nearest preset to the current target, so a custom --fps value joins the cycle
+	int current = 0;
+	for (int i = 0; i < presetCount; i++) {
+		if (std::abs(FRAME_LIMIT_PRESETS[i] - targetFps_) < std::abs(FRAME_LIMIT_PRESETS[current] - targetFps_)) {
+			current = i;
+		}
+	}
+
+	setTargetFps(FRAME_LIMIT_PRESETS[(current + direction + presetCount) % presetCount]);
+}
+
+/*
+-----~~~~~=====<<<<<{_STATS_}>>>>>=====~~~~~-----
+*/
+double FrameLimiter::getErrorMean() const {
+	return errorCount_ > 0 ? errorSum_ / errorCount_ : 0.0;
+}
+
+double FrameLimiter::getErrorStdDev() const {
+	if (errorCount_ == 0) {
+		return 0.0;
+	}
+	double mean = getErrorMean();
+	return std::sqrt(std::max(0.0, errorSquareSum_ / errorCount_ - mean * mean));
+}
+
+void FrameLimiter::resetStats() {
+	errorSum_ = 0.0;
+	errorSquareSum_ = 0.0;
+	errorCount_ = 0;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <string>
+#include <cmath>
+
+#include "util.h"
+
+// caps the main loop at a target rate. sleeps until shortly before the deadline,
+// then spins the rest of the way because sleeps overshoot by a scheduler tick
+class FrameLimiter {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// targetFps <= 0 means uncapped
+	void init(double targetFps);
+
+	// blocks until the next frame is due, call once per loop
+	void wait();
+
+	void setTargetFps(double targetFps);
+	double getTargetFps() const;
+	// step through FRAME_LIMIT_PRESETS (direction -1 or 1)
+	void cyclePreset(int direction);
+
+	// mean and standard deviation of how late wait() returned (microseconds) since the last reset
+	double getErrorMean() const;
+	double getErrorStdDev() const;
+	void resetStats();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "FrameLimiter::";
+
+private:
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	double targetFps_ = 0.0;
+	uint64_t periodNs_ = 0;
+	uint64_t nextFrameNs_ = 0;
+
+	// pacing error accumulators
+	double errorSum_ = 0.0;
+	double errorSquareSum_ = 0.0;
+	uint64_t errorCount_ = 0;
+};
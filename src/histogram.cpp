@@ -0,0 +1,54 @@
+#include "histogram.h"
+
+/*
+-----~~~~~=====<<<<<{_RECORDING_}>>>>>=====~~~~~-----
+*/
+void Histogram::record(double us) {
+	size_t bucket = us > 0.0 ? static_cast<size_t>(us / HISTOGRAM_BUCKET_US) : 0;
+	buckets_[std::min<size_t>(bucket, HISTOGRAM_BUCKETS)]++;
+
+	max_ = std::max(max_, us);
+	count_++;
+}
+
+void Histogram::reset() {
+	buckets_.fill(0);
+	max_ = 0.0;
+	count_ = 0;
+}
+
+/*
+-----~~~~~=====<<<<<{_QUERIES_}>>>>>=====~~~~~-----
+*/
+double Histogram::getPercentile(double p) const {
+	if (count_ == 0) {
+		return 0.0;
+	}
+
+	uint64_t rank = static_cast<uint64_t>(std::ceil(p * count_));
+	uint64_t seen = 0;
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		seen += buckets_[i];
+		if (seen >= rank) {
+			// never report more than was actually measured
+			return std::min((i + 1) * HISTOGRAM_BUCKET_US, max_);
+		}
+	}
+
+	// in the overflow bucket
+	return max_;
+}
+
+double Histogram::getMax() const { return max_; }
+uint64_t Histogram::getCount() const { return count_; }
+
+std::string Histogram::summary() const {
+	std::stringstream output;
+	output.setf(std::ios::fixed);
+	output.precision(3);
+	output << "p50: " << getPercentile(0.50) / 1000.0
+		<< " p90: " << getPercentile(0.90) / 1000.0
+		<< " p99: " << getPercentile(0.99) / 1000.0
+		<< " max: " << getMax() / 1000.0 << " ms";
+	return output.str();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <cmath>
+
+#include "util.h"
+
+// fixed bucket histogram of durations in microseconds. recording is one increment,
+// so it can sit in the hot loop, and percentiles come out to within a bucket width
+class Histogram {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void record(double us);
+
+	// upper edge of the bucket holding the p-th fraction of samples (0 < p <= 1)
+	double getPercentile(double p) const;
+	double getMax() const;
+	uint64_t getCount() const;
+
+	// "p50: .. p90: .. p99: .. max: .." in milliseconds
+	std::string summary() const;
+
+	void reset();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "Histogram::";
+
+private:
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	// last bucket catches everything past HISTOGRAM_BUCKETS * HISTOGRAM_BUCKET_US
+	std::array<uint32_t, HISTOGRAM_BUCKETS + 1> buckets_{};
+	double max_ = 0.0;
+	uint64_t count_ = 0;
+};
@@ -9,6 +9,11 @@
 
 #include "engine.h"
 
+// textures decode on several threads at once, stbi_failure_reason() only names the calling thread's failure when it is thread local
+#ifndef STBI_THREAD_LOCAL
+#error "stb_image has to be built with STBI_THREAD_LOCAL (do not define STBI_NO_THREAD_LOCALS)"
+#endif
+
 // Program entry point
 int main(int argv, char** args) {
     std::cout << "main function invocation\n";
@@ -16,7 +21,8 @@ int main(int argv, char** args) {
     Engine e;
 
     try {
-        e.run();
+        EngineConfig config = parseArgs(argv, args);
+        e.run(config);
     }
 
     catch (const std::exception& e) {
@@ -0,0 +1,104 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+bool MappedFile::open(const std::string& path) {
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	file_ = file;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+		close();
+		return false;
+	}
+	size_ = static_cast<size_t>(size.QuadPart);
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		close();
+		return false;
+	}
+	mapping_ = mapping;
+
+	data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	file_ = ::open(path.c_str(), O_RDONLY);
+	if (file_ < 0) {
+		return false;
+	}
+
+	struct stat info{};
+	if (fstat(file_, &info) != 0 || info.st_size == 0) {
+		close();
+		return false;
+	}
+	size_ = static_cast<size_t>(info.st_size);
+
+	void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_, 0);
+	data_ = data == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(data);
+#endif
+
+	if (data_ == nullptr) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+/*
+-----~~~~~=====<<<<<{_GETTERS_}>>>>>=====~~~~~-----
+*/
+const uint8_t* MappedFile::getData() const { return data_; }
+size_t MappedFile::getSize() const { return size_; }
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void MappedFile::close() {
+#ifdef _WIN32
+	if (data_ != nullptr) {
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_ != nullptr) {
+		CloseHandle(mapping_);
+	}
+	if (file_ != nullptr) {
+		CloseHandle(file_);
+	}
+	mapping_ = nullptr;
+	file_ = nullptr;
+#else
+	if (data_ != nullptr) {
+		munmap(const_cast<uint8_t*>(data_), size_);
+	}
+	if (file_ >= 0) {
+		::close(file_);
+	}
+	file_ = -1;
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+}
+
+MappedFile::~MappedFile() {
+	close();
+}
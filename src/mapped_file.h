@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+
+#include "util.h"
+
+// read only memory map of a whole file, unmapped on close() or destruction
+class MappedFile {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	// false if the file is missing, empty or cannot be mapped
+	bool open(const std::string& path);
+
+	const uint8_t* getData() const;
+	size_t getSize() const;
+
+	void close();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "MappedFile::";
+
+private:
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const uint8_t* data_ = nullptr;
+	size_t size_ = 0;
+
+#ifdef _WIN32
+	void* file_ = nullptr; // HANDLE
+	void* mapping_ = nullptr; // HANDLE
+#else
+	int file_ = -1;
+#endif
+};
@@ -0,0 +1,286 @@
+#include "pixel_cache.h"
+
+namespace fs = std::filesystem;
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void PixelCache::open(const std::string& path, int padding, int alignment) {
+	close();
+	path_ = path;
+	padding_ = padding;
+	alignment_ = alignment;
+
+	if (path_.empty()) {
+		return;
+	}
+
+	auto mapping = std::make_shared<MappedFile>();
+	if (!mapping->open(path_)) {
+		log(name_ + __func__, "no pixel cache at " + path_ + ", decoding everything");
+		return;
+	}
+
+	const uint8_t* data = mapping->getData();
+	size_t size = mapping->getSize();
+	size_t cursor = 0;
+
+	// every read is bounds checked, a truncated file is just a miss
+	auto read = [&](void* destination, size_t bytes) {
+		if (bytes > size - cursor) {
+			return false;
+		}
+		std::memcpy(destination, data + cursor, bytes);
+		cursor += bytes;
+		return true;
+	};
+
+	char magic[4];
+	uint32_t version = 0;
+	uint32_t filePadding = 0;
+	uint32_t fileAlignment = 0;
+	uint32_t entryCount = 0;
+	if (!read(magic, 4) || std::memcmp(magic, PIXEL_CACHE_MAGIC, 4) != 0 || !read(&version, 4)) {
+		log(name_ + __func__, "ignoring " + path_ + ", not a pixel cache");
+		return;
+	}
+	// the rest of the header moved between versions
+	if (version != PIXEL_CACHE_VERSION || !read(&filePadding, 4) || !read(&fileAlignment, 4) || !read(&entryCount, 4) ||
+		filePadding != static_cast<uint32_t>(padding_) || fileAlignment != static_cast<uint32_t>(alignment_)) {
+		log(name_ + __func__, "ignoring " + path_ + ", made by a different version or atlas layout");
+		return;
+	}
+
+	std::unordered_map<std::string, Entry> index{};
+	for (uint32_t i = 0; i < entryCount; i++) {
+		uint32_t pathLength = 0;
+		if (!read(&pathLength, 4) || pathLength > size - cursor) {
+			log(name_ + __func__, "ignoring " + path_ + ", truncated");
+			return;
+		}
+		std::string filename(reinterpret_cast<const char*>(data + cursor), pathLength);
+		cursor += pathLength;
+
+		Entry entry{};
+		int32_t width = 0;
+		int32_t height = 0;
+		int32_t sourceWidth = 0;
+		int32_t sourceHeight = 0;
+		if (!read(&entry.mtime, 8) || !read(&entry.fileSize, 8) || !read(&entry.contentHash, 8) || !read(&width, 4) || !read(&height, 4) ||
+			!read(&sourceWidth, 4) || !read(&sourceHeight, 4) || !read(&entry.offset, 8)) {
+			log(name_ + __func__, "ignoring " + path_ + ", truncated");
+			return;
+		}
+
+		uint64_t pixelBytes = static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4;
+		if (width <= 0 || height <= 0 || sourceWidth <= 0 || sourceHeight <= 0 || entry.offset > size || pixelBytes > size - entry.offset) {
+			log(name_ + __func__, "ignoring " + path_ + ", entry for " + filename + " is out of bounds");
+			return;
+		}
+		entry.width = width;
+		entry.height = height;
+		entry.sourceWidth = sourceWidth;
+		entry.sourceHeight = sourceHeight;
+		index[filename] = entry;
+	}
+
+	mapping_ = mapping;
+	index_ = std::move(index);
+	log(name_ + __func__, "mapped " + std::to_string(index_.size()) + " cached images from " + path_);
+}
+
+/*
+-----~~~~~=====<<<<<{_LOOKUP_}>>>>>=====~~~~~-----
+*/
+bool PixelCache::find(const std::string& filename, DecodedImage& image) {
+	auto found = index_.find(filename);
+	if (found == index_.end()) {
+		return false;
+	}
+
+	int64_t mtime;
+	uint64_t fileSize;
+	if (!readStamp(filename, mtime, fileSize)) {
+		return false;
+	}
+
+	// same stamp is taken on trust, a new one (checkout, copy) still hits if the bytes are the same
+	Entry entry = found->second;
+	bool restamped = false;
+	if (entry.mtime != mtime || entry.fileSize != fileSize) {
+		uint64_t hash;
+		if (!hashFile(filename, hash) || hash != entry.contentHash) {
+			return false;
+		}
+		entry.mtime = mtime;
+		entry.fileSize = fileSize;
+		restamped = true;
+	}
+
+	// aliases the mapping, it stays mapped while any of these pixels are around
+	entry.pixels = std::shared_ptr<const uint8_t>(mapping_, mapping_->getData() + entry.offset);
+	image.width = entry.width;
+	image.height = entry.height;
+	image.sourceWidth = entry.sourceWidth;
+	image.sourceHeight = entry.sourceHeight;
+	image.pixels = entry.pixels;
+
+	std::lock_guard<std::mutex> lock(keptMutex_);
+	kept_.push_back({ filename, entry });
+	dirty_ = dirty_ || restamped;
+	return true;
+}
+
+void PixelCache::add(const std::string& filename, const DecodedImage& image) {
+	if (path_.empty() || !image.pixels) {
+		return;
+	}
+
+	Entry entry{};
+	if (!readStamp(filename, entry.mtime, entry.fileSize) || !hashFile(filename, entry.contentHash)) {
+		log(name_ + __func__, "could not stamp " + filename + ", leaving it out of the cache");
+		return;
+	}
+	entry.width = image.width;
+	entry.height = image.height;
+	entry.sourceWidth = image.sourceWidth;
+	entry.sourceHeight = image.sourceHeight;
+	entry.pixels = image.pixels;
+
+	std::lock_guard<std::mutex> lock(keptMutex_);
+	kept_.push_back({ filename, entry });
+	dirty_ = true;
+}
+
+bool PixelCache::readStamp(const std::string& filename, int64_t& mtime, uint64_t& fileSize) {
+	std::error_code error;
+	auto time = fs::last_write_time(filename, error);
+	if (error) {
+		return false;
+	}
+	fileSize = fs::file_size(filename, error);
+	if (error) {
+		return false;
+	}
+	mtime = static_cast<int64_t>(time.time_since_epoch().count());
+	return true;
+}
+
+bool PixelCache::hashFile(const std::string& filename, uint64_t& hash) {
+	MappedFile file;
+	if (!file.open(filename)) {
+		return false;
+	}
+
+	// FNV-1a, 64 bit
+	hash = 14695981039346656037ull;
+	const uint8_t* data = file.getData();
+	for (size_t i = 0; i < file.getSize(); i++) {
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	return true;
+}
+
+/*
+-----~~~~~=====<<<<<{_WRITING_}>>>>>=====~~~~~-----
+*/
+void PixelCache::write() {
+	std::lock_guard<std::mutex> lock(keptMutex_);
+
+	// nothing new and nothing gone stale
+	if (path_.empty() || (!dirty_ && kept_.size() == index_.size())) {
+		return;
+	}
+
+	auto align = [](uint64_t offset) { return (offset + PIXEL_CACHE_ALIGNMENT - 1) & ~static_cast<uint64_t>(PIXEL_CACHE_ALIGNMENT - 1); };
+
+	// header and entry table first, the pixels follow
+	uint64_t offset = 20;
+	for (const auto& [filename, entry] : kept_) {
+		offset += 4 + filename.size() + 8 + 8 + 8 + 4 + 4 + 4 + 4 + 8;
+	}
+	for (auto& [filename, entry] : kept_) {
+		entry.offset = align(offset);
+		offset = entry.offset + static_cast<uint64_t>(entry.width) * entry.height * 4;
+	}
+
+	// written next to the old file and swapped in, so a crash never leaves half a cache behind
+	std::string temporaryPath = path_ + ".tmp";
+	std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		log(name_ + __func__, "could not write " + temporaryPath);
+		return;
+	}
+
+	uint32_t version = PIXEL_CACHE_VERSION;
+	uint32_t padding = static_cast<uint32_t>(padding_);
+	uint32_t alignment = static_cast<uint32_t>(alignment_);
+	uint32_t entryCount = static_cast<uint32_t>(kept_.size());
+	out.write(PIXEL_CACHE_MAGIC, 4);
+	out.write(reinterpret_cast<const char*>(&version), 4);
+	out.write(reinterpret_cast<const char*>(&padding), 4);
+	out.write(reinterpret_cast<const char*>(&alignment), 4);
+	out.write(reinterpret_cast<const char*>(&entryCount), 4);
+
+	for (const auto& [filename, entry] : kept_) {
+		uint32_t pathLength = static_cast<uint32_t>(filename.size());
+		int32_t width = entry.width;
+		int32_t height = entry.height;
+		int32_t sourceWidth = entry.sourceWidth;
+		int32_t sourceHeight = entry.sourceHeight;
+		out.write(reinterpret_cast<const char*>(&pathLength), 4);
+		out.write(filename.data(), pathLength);
+		out.write(reinterpret_cast<const char*>(&entry.mtime), 8);
+		out.write(reinterpret_cast<const char*>(&entry.fileSize), 8);
+		out.write(reinterpret_cast<const char*>(&entry.contentHash), 8);
+		out.write(reinterpret_cast<const char*>(&width), 4);
+		out.write(reinterpret_cast<const char*>(&height), 4);
+		out.write(reinterpret_cast<const char*>(&sourceWidth), 4);
+		out.write(reinterpret_cast<const char*>(&sourceHeight), 4);
+		out.write(reinterpret_cast<const char*>(&entry.offset), 8);
+	}
+
+	const char zeros[PIXEL_CACHE_ALIGNMENT] = {};
+	for (const auto& [filename, entry] : kept_) {
+		out.write(zeros, static_cast<std::streamsize>(entry.offset - static_cast<uint64_t>(out.tellp())));
+		out.write(reinterpret_cast<const char*>(entry.pixels.get()), static_cast<std::streamsize>(entry.width) * entry.height * 4);
+	}
+
+	out.close();
+	if (!out) {
+		log(name_ + __func__, "could not write " + temporaryPath);
+		std::error_code error;
+		fs::remove(temporaryPath, error);
+		return;
+	}
+
+	size_t written = kept_.size();
+
+	// the old mapping has to be gone before its file is replaced (windows will not replace a mapped file)
+	kept_.clear();
+	index_.clear();
+	mapping_.reset();
+	dirty_ = false;
+
+	std::error_code error;
+	fs::rename(temporaryPath, path_, error);
+	if (error) {
+		log(name_ + __func__, "could not replace " + path_ + ": " + error.message());
+		fs::remove(temporaryPath, error);
+		return;
+	}
+
+	log(name_ + __func__, "wrote " + std::to_string(written) + " images to " + path_);
+}
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void PixelCache::close() {
+	std::lock_guard<std::mutex> lock(keptMutex_);
+	kept_.clear();
+	index_.clear();
+	mapping_.reset();
+	dirty_ = false;
+}
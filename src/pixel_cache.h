@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <filesystem>
+
+#include "util.h"
+#include "mapped_file.h"
+
+// decoded (and atlas padded) RGBA8 pixels of every image from the last run, in one file that is memory mapped
+// at startup. an entry is keyed on the source path and holds on while the source keeps its mtime and size, or
+// failing that its FNV-1a content hash. layout, native byte order:
+//   "SSPC", u32 version, u32 padding, u32 alignment, u32 entry count
+//   per entry: u32 path length, path, i64 mtime, u64 file size, u64 content hash, i32 width, i32 height,
+//              i32 source width, i32 source height, u64 pixel offset
+//   pixels, every entry at a PIXEL_CACHE_ALIGNMENT boundary
+// nothing here is fatal, a missing or broken cache only means decoding everything again
+class PixelCache {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// maps path if it holds a cache made with the same padding and alignment (see Texture::pad()), an empty path turns the cache off
+	void open(const std::string& path, int padding, int alignment);
+
+	// thread safe. the cached pixels of filename if the source has not changed, they point
+	// straight into the mapping and keep it alive
+	bool find(const std::string& filename, DecodedImage& image);
+	// thread safe. a freshly decoded image to store on the next write()
+	void add(const std::string& filename, const DecodedImage& image);
+
+	// rewrites the file with every image found or added since open(), if anything changed
+	void write();
+	void close();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "PixelCache::";
+
+private:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	static bool readStamp(const std::string& filename, int64_t& mtime, uint64_t& fileSize);
+	static bool hashFile(const std::string& filename, uint64_t& hash);
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	struct Entry {
+		int64_t mtime = 0;
+		uint64_t fileSize = 0;
+		uint64_t contentHash = 0;
+		int width = 0;
+		int height = 0;
+		int sourceWidth = 0;
+		int sourceHeight = 0;
+		uint64_t offset = 0;
+		std::shared_ptr<const uint8_t> pixels{};
+	};
+
+	std::string path_{};
+	int padding_ = 0;
+	int alignment_ = 1;
+
+	// what the mapped file holds, read only after open()
+	std::shared_ptr<MappedFile> mapping_{};
+	std::unordered_map<std::string, Entry> index_{};
+
+	// what the next write() stores, found and added images alike
+	std::mutex keptMutex_;
+	std::vector<std::pair<std::string, Entry>> kept_{};
+	bool dirty_ = false;
+};
@@ -0,0 +1,115 @@
+#include "present_waiter.h"
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void PresentWaiter::init(VkDevice device, PFN_vkWaitForPresentKHR waitForPresent, VkSwapchainKHR swapchain) {
+	log(name_ + __func__, "starting present wait thread");
+
+	device_ = device;
+	waitForPresent_ = waitForPresent;
+	swapchain_ = swapchain;
+
+	running_ = true;
+	thread_ = std::thread(&PresentWaiter::threadLoop, this);
+}
+
+/*
+-----~~~~~=====<<<<<{_MAIN_THREAD_}>>>>>=====~~~~~-----
+*/
+std::unique_lock<std::mutex> PresentWaiter::lockSwapchain() {
+	swapchainWanted_++;
+	std::unique_lock<std::mutex> lock(swapchainMutex_);
+	swapchainWanted_--;
+	return lock;
+}
+
+void PresentWaiter::setSwapchain(VkSwapchainKHR swapchain) {
+	std::unique_lock<std::mutex> swapchainLock = lockSwapchain();
+	std::lock_guard<std::mutex> pendingLock(pendingMutex_);
+
+	// ids are only compared within one swapchain
+	swapchain_ = swapchain;
+	generation_++;
+	pending_.clear();
+}
+
+void PresentWaiter::push(uint64_t presentId, uint64_t inputNs) {
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex_);
+		pending_.push_back({ presentId, inputNs });
+	}
+	pendingChanged_.notify_one();
+}
+
+void PresentWaiter::collect(std::vector<double>& latenciesUs) {
+	latenciesUs.clear();
+	std::lock_guard<std::mutex> lock(pendingMutex_);
+	std::swap(latenciesUs, latenciesUs_);
+}
+
+/*
+-----~~~~~=====<<<<<{_WAITER_THREAD_}>>>>>=====~~~~~-----
+*/
+void PresentWaiter::threadLoop() {
+	while (running_) {
+		Pending pending;
+		uint64_t generation;
+		{
+			std::unique_lock<std::mutex> lock(pendingMutex_);
+			pendingChanged_.wait(lock, [&]() { return !running_ || !pending_.empty(); });
+			if (!running_) {
+				return;
+			}
+			pending = pending_.front();
+			generation = generation_;
+		}
+
+		// sliced, so acquire and present are never held up for longer than one slice
+		VkResult result = VK_TIMEOUT;
+		while (result == VK_TIMEOUT && running_) {
+			while (swapchainWanted_ > 0) {
+				std::this_thread::yield();
+			}
+
+			std::lock_guard<std::mutex> lock(swapchainMutex_);
+			if (generation != generation_ || swapchain_ == VK_NULL_HANDLE) {
+				break;
+			}
+			result = waitForPresent_(device_, swapchain_, pending.presentId, PRESENT_WAIT_SLICE_NS);
+		}
+		uint64_t shownNs = SDL_GetTicksNS();
+
+		std::lock_guard<std::mutex> lock(pendingMutex_);
+		// a new swapchain already cleared the queue
+		if (generation != generation_) {
+			continue;
+		}
+		if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+			latenciesUs_.push_back(static_cast<double>(shownNs - pending.inputNs) / 1000.0);
+		}
+		// errors (out of date, surface lost) drop the sample, nothing will report it shown
+		if (result != VK_TIMEOUT) {
+			pending_.pop_front();
+		}
+	}
+}
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void PresentWaiter::cleanup() {
+	if (thread_.joinable()) {
+		log(name_ + __func__, "stopping present wait thread");
+		{
+			std::lock_guard<std::mutex> lock(pendingMutex_);
+			running_ = false;
+		}
+		pendingChanged_.notify_one();
+		thread_.join();
+	}
+}
+
+PresentWaiter::~PresentWaiter() {
+	cleanup();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util.h"
+
+// waits on present ids (VK_KHR_present_wait) on its own thread and timestamps each wait as it returns,
+// which is when the image was shown. vkWaitForPresentKHR needs the swapchain externally synchronized, so
+// the waits run in PRESENT_WAIT_SLICE_NS slices under the lock the main thread takes around acquire and present
+class PresentWaiter {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// starts the thread
+	void init(VkDevice device, PFN_vkWaitForPresentKHR waitForPresent, VkSwapchainKHR swapchain);
+
+	// main thread, around vkAcquireNextImageKHR, vkQueuePresentKHR and swapchain creation
+	std::unique_lock<std::mutex> lockSwapchain();
+	// main thread: presents still pending on the old swapchain are dropped, VK_NULL_HANDLE before it is retired
+	void setSwapchain(VkSwapchainKHR swapchain);
+
+	// main thread, after a present that carried presentId and handled input from inputNs (SDL_GetTicksNS time)
+	void push(uint64_t presentId, uint64_t inputNs);
+	// input to present times (us) finished since the last call, replaces what latenciesUs held
+	void collect(std::vector<double>& latenciesUs);
+
+	// stops and joins the thread
+	void cleanup();
+	// a thread still running on an exception path would take the process down
+	~PresentWaiter();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "PresentWaiter::";
+
+private:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void threadLoop();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	struct Pending {
+		uint64_t presentId;
+		uint64_t inputNs;
+	};
+
+	VkDevice device_ = VK_NULL_HANDLE;
+	PFN_vkWaitForPresentKHR waitForPresent_ = nullptr;
+
+	// swapchain_ and generation_ change with both locks held, so either lock is enough to read them
+	std::mutex swapchainMutex_;
+	VkSwapchainKHR swapchain_ = VK_NULL_HANDLE;
+	uint64_t generation_ = 0;
+	// the waiter steps aside between slices while the main thread wants the swapchain
+	std::atomic<int> swapchainWanted_{ 0 };
+
+	std::mutex pendingMutex_;
+	std::condition_variable pendingChanged_;
+	std::deque<Pending> pending_{};
+	std::vector<double> latenciesUs_{};
+
+	std::atomic<bool> running_{ false };
+	std::thread thread_;
+};
@@ -0,0 +1,48 @@
+#include "body.h"
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void Body::create(SpriteStore& spriteStore, const std::string& id, glm::vec2 position, glm::vec2 sizePercent, const TextureRegion& texture, glm::vec2 velocity) {
+	position_ = position;
+	previousPosition_ = position;
+	// unscaled, only used to keep the body on screen
+	extent_ = sizePercent * 2.f;
+	velocity_ = velocity;
+
+	sprite_ = spriteStore.add(id, position, sizePercent, texture);
+}
+
+/*
+-----~~~~~=====<<<<<{_UPDATES_}>>>>>=====~~~~~-----
+*/
+void Body::update(float dt) {
+	previousPosition_ = position_;
+	position_ += velocity_ * dt;
+
+	// bounce off the edges of [-1, 1]
+	for (int axis = 0; axis < 2; axis++) {
+		if (position_[axis] < -1.f) {
+			position_[axis] = -1.f;
+			velocity_[axis] = std::abs(velocity_[axis]);
+		}
+		else if (position_[axis] + extent_[axis] > 1.f) {
+			position_[axis] = 1.f - extent_[axis];
+			velocity_[axis] = -std::abs(velocity_[axis]);
+		}
+	}
+}
+
+/*
+-----~~~~~=====<<<<<{_HELPFUL_}>>>>>=====~~~~~-----
+*/
+int Body::getSprite() const { return sprite_; }
+glm::vec2 Body::getPosition() const { return position_; }
+glm::vec2 Body::getPreviousPosition() const { return previousPosition_; }
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void Body::destroy() {
+
+}
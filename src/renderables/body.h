@@ -0,0 +1,33 @@
+#pragma once
+
+#include "../util.h"
+#include "sprite_store.h"
+
+// sprite that drifts at a constant velocity and bounces off the screen edges
+class Body {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void create(SpriteStore& spriteStore, const std::string& id, glm::vec2 position, glm::vec2 sizePercent, const TextureRegion& texture, glm::vec2 velocity);
+
+	// one fixed simulation tick, moves the body by velocity * dt (simulation thread)
+	void update(float dt);
+
+	// index in the sprite store
+	int getSprite() const;
+	glm::vec2 getPosition() const;
+	glm::vec2 getPreviousPosition() const;
+
+	void destroy();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "Body::";
+
+private:
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	int sprite_ = -1;
+
+	glm::vec2 position_ = { 0.f, 0.f };
+	glm::vec2 previousPosition_ = { 0.f, 0.f };
+	glm::vec2 extent_ = { 0.f, 0.f };
+	glm::vec2 velocity_ = { 0.f, 0.f };
+};
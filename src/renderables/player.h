@@ -1,19 +1,24 @@
 #pragma once
 
 #include "../util.h"
+#include "sprite_store.h"
 
 class Player {
 public:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
-	void init(GameState& gameState, glm::vec2 position, glm::vec2 sizePercent, int textureIndex);
+	void init(GameState& gameState, SpriteStore& spriteStore, glm::vec2 position, glm::vec2 sizePercent, const TextureRegion& texture);
 
-	void update();
+	// one fixed simulation tick of dt seconds (simulation thread)
+	void update(float dt);
 
-	int map(Vertex* mapped);
+	// index in the sprite store
+	int getSprite() const;
+	// at the end of the last tick and at its start, rendering interpolates between them
+	glm::vec2 getPosition() const;
+	glm::vec2 getPreviousPosition() const;
 
 	// utility
-	void scale();
-	void onKey();
+	void onKey(const KeyState& keys);
 
 	void cleanup();
 
@@ -24,19 +29,18 @@ private:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
 
 	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
-	std::array<Vertex, 4> vertices_{};
-
 	GameState* gameState_ = nullptr;
+	int sprite_ = -1;
 
 	bool noX_ = true;
 	bool noY_ = true;
 	bool airborne_ = true;
     bool stopped_ = false;
 
-	int textureIndex_ = -1;
     glm::vec2 acceleration_ = { 0.f, 0.f };
 	glm::vec2 velocity_ = { 0.f, 0.f };
 	glm::vec2 position_ = { 0.f, 0.f };
+	glm::vec2 previousPosition_ = { 0.f, 0.f }; // at the start of the last tick
 	glm::vec2 sizePercent_ = { 0.f, 0.f };
 
 };
@@ -3,77 +3,17 @@
 /*
 -----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
 */
-void Rectangle::create(GameState& gameState, GameScreens screen, bool collidable, const std::string& id, glm::vec2 position, glm::vec2 sizePercent, int textureIndex) {
-	
-	gameState_ = &gameState;
+void Rectangle::create(SpriteStore& spriteStore, GameScreens screen, bool collidable, const std::string& id, glm::vec2 position, glm::vec2 sizePercent, const TextureRegion& texture) {
 	screen_ = screen;
 	collidable_ = collidable;
 
-	id_ = id;
-	position_ = position;
-	sizePercent_ = sizePercent;
-	textureIndex_ = textureIndex;
-
-	// initialize vertices
-	float xOffset = (sizePercent_.x * 2) * gameState_->spriteScale;
-	float yOffset = (sizePercent_.y * 2) * gameState_->spriteScale;
-
-	// top left
-	vertices_[0].pos = { position_.x, position_.y };
-	vertices_[0].texCoord = { 0, 0 };
-	vertices_[0].texIndex = textureIndex_;
-	vertices_[0].interaction = 0;
-
-	// bottom left
-	vertices_[1].pos = { position_.x, position_.y + yOffset };
-	vertices_[1].texCoord = { 0, 1 };
-	vertices_[1].texIndex = textureIndex_;
-	vertices_[1].interaction = 0;
-
-	// top right
-	vertices_[2].pos = { position_.x + xOffset, position_.y };
-	vertices_[2].texCoord = { 1, 0 };
-	vertices_[2].texIndex = textureIndex_;
-	vertices_[2].interaction = 0;
-
-	// bottom right
-	vertices_[3].pos = { position_.x + xOffset, position_.y + yOffset };
-	vertices_[3].texCoord = { 1, 1 };
-	vertices_[3].texIndex = textureIndex_;
-	vertices_[3].interaction = 0;
-
+	sprite_ = spriteStore.add(id, position, sizePercent, texture);
 }
 
 /*
 -----~~~~~=====<<<<<{_HELPFUL_}>>>>>=====~~~~~-----
 */
-int Rectangle::map(Vertex* mapped) {
-	for (int i = 0; i < 4; i++) {
-		mapped->pos.x = vertices_[i].pos.x; // position x
-		mapped->pos.y = vertices_[i].pos.y; // position y
-		mapped->texCoord.x = vertices_[i].texCoord.x; // tex coord x
-		mapped->texCoord.y = vertices_[i].texCoord.y; // tex coord y
-		mapped->texIndex = vertices_[i].texIndex; // tex index
-		mapped->interaction = vertices_[i].interaction; // for checking hover
-		mapped++;
-	}
-	return 4;
-}
-
-void Rectangle::scale() {
-	// calculate x and y offsets
-	float xOffset = (sizePercent_.x * 2) * gameState_->spriteScale;
-	float yOffset = (sizePercent_.y * 2) * gameState_->spriteScale;
-
-	// bottom left
-	vertices_[1].pos = { position_.x, position_.y + yOffset };
-
-	// top right
-	vertices_[2].pos = { position_.x + xOffset, position_.y };
-
-	// bottom right
-	vertices_[3].pos = { position_.x + xOffset, position_.y + yOffset };
-}
+int Rectangle::getSprite() const { return sprite_; }
 
 /*
 -----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
@@ -81,4 +21,3 @@ void Rectangle::scale() {
 void Rectangle::destroy() {
 
 }
-
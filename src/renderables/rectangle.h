@@ -1,38 +1,32 @@
 #pragma once
 
 #include "../util.h"
+#include "sprite_store.h"
 
 class Rectangle {
 public:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
-	void create(GameState& gameState, GameScreens screen, bool collidable, const std::string& id, glm::vec2 position, glm::vec2 sizePercent, int textureIndex);
+	void create(SpriteStore& spriteStore, GameScreens screen, bool collidable, const std::string& id, glm::vec2 position, glm::vec2 sizePercent, const TextureRegion& texture);
 
-	int map(Vertex* mapped);
+	// index in the sprite store
+	int getSprite() const;
 
 	// utility
 	//bool isHovered();
-	void scale();
 
 	void destroy();
 
 	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
-	std::string id_ = "";
-
 	const std::string name_ = "Rectangle::";
 
 private:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
 
 	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
-	std::array<Vertex, 4> vertices_{};
+	// position, size, texture and id live in the sprite store
+	int sprite_ = -1;
 
 	GameScreens screen_ = NONE;
 	bool collidable_ = false;
 
-	GameState* gameState_ = nullptr;
-
-	int textureIndex_ = -1;
-	glm::vec2 position_ = { 0.f, 0.f };
-	glm::vec2 sizePercent_ = { 0.f, 0.f };
-
-};
\ No newline at end of file
+};
@@ -9,6 +9,8 @@ void RenderableManager::init(GameState& gameState, AssetManager& assetManager) {
 	gameState_ = &gameState;
 	assetManager_ = &assetManager;
 
+	spriteStore_.scale(gameState_->spriteScale);
+
 	generateWorld();
 }
 
@@ -17,71 +19,215 @@ void RenderableManager::generateWorld() {
 
 	// sky
 	Rectangle sky;
-	sky.create(*gameState_, GAMEPLAY, false, "sky", { -1.f, -1.f }, { 1.f, 1.f }, assetManager_->getTextureIndex("../res/img/png/sky2.png"));
+	sky.create(spriteStore_, GAMEPLAY, false, "sky", { -1.f, -1.f }, { 1.f, 1.f }, assetManager_->getTextureRegion("../res/img/png/sky2.png"));
 	rectangles_.push_back(sky);
 
 	// floor
 	Rectangle floor;
-	floor.create(*gameState_, GAMEPLAY, true, "floor", { -1.f, 0.75f }, { 1.f, 0.125f }, assetManager_->getTextureIndex("../res/img/png/floor.png"));
+	floor.create(spriteStore_, GAMEPLAY, true, "floor", { -1.f, 0.75f }, { 1.f, 0.125f }, assetManager_->getTextureRegion("../res/img/png/floor.png"));
 	rectangles_.push_back(floor);
 
 
 	// last = player
-	player_.init(*gameState_, { 0,0 }, { 0.02f, 0.1f }, assetManager_->getTextureIndex("../res/img/png/player.png"));
+	player_.init(*gameState_, spriteStore_, { 0,0 }, { 0.02f, 0.1f }, assetManager_->getTextureRegion("../res/img/png/player.png"));
+
+	markAllDirty();
+}
+
+void RenderableManager::generateBenchScene(int count, uint32_t seed) {
+	log(name_ + __func__, "generating bench scene, " + std::to_string(count) + " sprites, seed " + std::to_string(seed));
+
+	std::mt19937 rng(seed);
+	int textureCount = assetManager_->getRegionCount();
+
+	for (int i = 0; i < count; i++) {
+		// every draw is the same work for a given seed: position, size, texture, velocity
+		glm::vec2 sizePercent = { 0.005f + randomFloat(rng) * 0.02f, 0.005f + randomFloat(rng) * 0.02f };
+		glm::vec2 position = { randomFloat(rng) * 2.f - 1.f, randomFloat(rng) * 2.f - 1.f };
+		const TextureRegion& texture = assetManager_->getTextureRegion(std::min(static_cast<int>(randomFloat(rng) * textureCount), textureCount - 1));
+
+		if (i % BENCH_BODY_INTERVAL == 0) {
+			glm::vec2 velocity = { randomFloat(rng) - 0.5f, randomFloat(rng) - 0.5f };
+			Body body;
+			body.create(spriteStore_, "bench_body", position, sizePercent, texture, velocity);
+			bodies_.push_back(body);
+		}
+		else {
+			Rectangle rectangle;
+			rectangle.create(spriteStore_, GAMEPLAY, false, "bench_rectangle", position, sizePercent, texture);
+			rectangles_.push_back(rectangle);
+		}
+	}
+
+	markAllDirty();
 }
 
 /*
 -----~~~~~=====<<<<<{_UPDATES_}>>>>>=====~~~~~-----
 */
-void RenderableManager::updateAll() {
+void RenderableManager::updateAll(float dt) {
+	player_.update(dt);
+
+	for (Body& body : bodies_) {
+		body.update(dt);
+	}
+}
+
+void RenderableManager::onKey(const KeyState& keys) {
 	// for now, just update player
-	player_.update();
+	player_.onKey(keys);
+}
+
+void RenderableManager::writeSnapshot(SimSnapshot& snapshot) const {
+	// the snapshot slots are reused, so this only allocates while the scene grows
+	snapshot.sprites.clear();
+	snapshot.previous.clear();
+	snapshot.current.clear();
+
+	snapshot.sprites.push_back(player_.getSprite());
+	snapshot.previous.push_back(player_.getPreviousPosition());
+	snapshot.current.push_back(player_.getPosition());
+
+	for (const Body& body : bodies_) {
+		snapshot.sprites.push_back(body.getSprite());
+		snapshot.previous.push_back(body.getPreviousPosition());
+		snapshot.current.push_back(body.getPosition());
+	}
+}
+
+void RenderableManager::applySnapshot(const SimSnapshot& snapshot, float alpha) {
+	for (size_t i = 0; i < snapshot.sprites.size(); i++) {
+		glm::vec2 position = glm::mix(snapshot.previous[i], snapshot.current[i], alpha);
+		if (position == spriteStore_.getPosition(snapshot.sprites[i])) {
+			continue;
+		}
+
+		spriteStore_.setPosition(snapshot.sprites[i], position);
+		markDirty(snapshot.sprites[i]);
+	}
 }
 
 int RenderableManager::mapAll(Vertex* mapped) {
-	//log(name_ + __func__, "Mapping everything to the buffer");
+	spriteStore_.writeVertices(0, spriteStore_.getCount(), mapped);
+	return getVertexCount();
+}
 
-	int offset = 0;
-	int vertexCount = 0;
+int RenderableManager::mapDirty(Vertex* mapped, uint32_t frame, std::vector<VertexRange>& ranges) {
+	size_t begin = ranges.size();
+	collectDirtyRanges(frame, ranges);
 
-	// rectangles
-	for (int i = 0; i < rectangles_.size(); i++) {
-		offset = rectangles_[i].map(mapped);
-		mapped += offset;
-		vertexCount += offset;
+	for (size_t i = begin; i < ranges.size(); i++) {
+		spriteStore_.writeVertices(ranges[i].first, ranges[i].count, mapped + ranges[i].first * 4);
+		ranges[i].first *= 4;
+		ranges[i].count *= 4;
 	}
 
-	// other
+	return getVertexCount();
+}
 
+int RenderableManager::mapDirtyPacked(PackedVertex* mapped, uint32_t frame, std::vector<VertexRange>& ranges) {
+	size_t begin = ranges.size();
+	collectDirtyRanges(frame, ranges);
 
-	// LAST = player
-	offset = player_.map(mapped);
-	mapped += offset;
-	vertexCount += offset;
+	for (size_t i = begin; i < ranges.size(); i++) {
+		spriteStore_.writePackedVertices(ranges[i].first, ranges[i].count, mapped + ranges[i].first * 4);
+		ranges[i].first *= 4;
+		ranges[i].count *= 4;
+	}
 
-	return vertexCount;
+	return getVertexCount();
 }
 
-void RenderableManager::scale() {
-	// rectangles
-	for (int i = 0; i < rectangles_.size(); i++) {
-		rectangles_[i].scale();
+int RenderableManager::mapDirtyInstances(SpriteInstance* mapped, uint32_t frame, std::vector<VertexRange>& ranges) {
+	size_t begin = ranges.size();
+	collectDirtyRanges(frame, ranges);
+
+	for (size_t i = begin; i < ranges.size(); i++) {
+		spriteStore_.writeInstances(ranges[i].first, ranges[i].count, mapped + ranges[i].first);
 	}
 
-	// other
+	return spriteStore_.getCount();
+}
 
-	player_.scale();
+int RenderableManager::getVertexCount() const { return spriteStore_.getCount() * 4; }
+
+void RenderableManager::scale() {
+	// all sprite extents in one pass over the store
+	spriteStore_.scale(gameState_->spriteScale);
 
 	// re-map
-	gameState_->needTriangleRemap = true;
+	markAllDirty();
 }
 
-void RenderableManager::onKey() {
-	// for now, just update player
-	player_.onKey();
+/*
+-----~~~~~=====<<<<<{_DIRTY_TRACKING_}>>>>>=====~~~~~-----
+*/
+void RenderableManager::collectDirtyRanges(uint32_t frame, std::vector<VertexRange>& ranges) {
+	std::vector<int>& sprites = dirtySprites_[frame];
+
+	// everything changed, one range covers it
+	if (allDirtyFrames_ & (1 << frame)) {
+		if (spriteStore_.getCount() > 0) {
+			ranges.push_back({ 0, static_cast<uint32_t>(spriteStore_.getCount()) });
+		}
+		for (int sprite : sprites) {
+			dirtyFrames_[sprite] &= ~(1 << frame);
+		}
+		sprites.clear();
+		allDirtyFrames_ &= ~(1 << frame);
+		return;
+	}
 
-	// re-map
-	gameState_->needTriangleRemap = true;
+	std::sort(sprites.begin(), sprites.end());
+
+	size_t begin = ranges.size();
+	for (int sprite : sprites) {
+		uint32_t first = static_cast<uint32_t>(sprite);
+
+		// merge with the previous range when the sprites are adjacent
+		if (ranges.size() > begin && ranges.back().first + ranges.back().count == first) {
+			ranges.back().count++;
+		}
+		else {
+			ranges.push_back({ first, 1 });
+		}
+
+		dirtyFrames_[sprite] &= ~(1 << frame);
+	}
+	sprites.clear();
+}
+
+void RenderableManager::markDirty(int sprite) {
+	if (dirtyFrames_.size() < spriteStore_.getCount()) {
+		dirtyFrames_.resize(spriteStore_.getCount(), 0);
+	}
+
+	// queue the sprite once for every frame that has not already got it queued
+	for (int frame = 0; frame < dirtyTargets_; frame++) {
+		if (!(dirtyFrames_[sprite] & (1 << frame))) {
+			dirtyFrames_[sprite] |= (1 << frame);
+			dirtySprites_[frame].push_back(sprite);
+		}
+	}
+}
+
+void RenderableManager::markAllDirty() {
+	if (dirtyFrames_.size() < spriteStore_.getCount()) {
+		dirtyFrames_.resize(spriteStore_.getCount(), 0);
+	}
+
+	allDirtyFrames_ = (1 << dirtyTargets_) - 1;
+}
+
+void RenderableManager::setDirtyTargets(int targets) {
+	dirtyTargets_ = targets;
+
+	// start over, nothing queued so far is valid for the new targets
+	for (std::vector<int>& sprites : dirtySprites_) {
+		sprites.clear();
+	}
+	std::fill(dirtyFrames_.begin(), dirtyFrames_.end(), 0);
+	markAllDirty();
 }
 
 /*
@@ -93,6 +239,14 @@ void RenderableManager::cleanup() {
 		rectangles_[i].destroy();
 	}
 
+	for (int i = 0; i < bodies_.size(); i++) {
+		bodies_[i].destroy();
+	}
+	bodies_.clear();
+	rectangles_.clear();
+
 	// other
+	player_.cleanup();
 
+	spriteStore_.clear();
 }
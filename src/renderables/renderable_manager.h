@@ -2,8 +2,10 @@
 
 #include "../util.h"
 #include "../asset_manager.h"
+#include "sprite_store.h"
 #include "rectangle.h"
 #include "player.h"
+#include "body.h"
 
 
 class RenderableManager {
@@ -11,12 +13,38 @@ public:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
 	void init(GameState& gameState, AssetManager& assetManager);
 
-	void updateAll();
+	// stress scene for --bench: count sprites, one in BENCH_BODY_INTERVAL moving, all from seed
+	void generateBenchScene(int count, uint32_t seed);
 
+	// simulation side (simulation thread when it has one). touches the player and bodies, never the sprite store
+	// one fixed simulation tick of dt seconds for everything that moves
+	void updateAll(float dt);
+	void onKey(const KeyState& keys);
+	// fills the moving sprites' positions at the start and end of the last tick
+	void writeSnapshot(SimSnapshot& snapshot) const;
+
+	// render side (main thread). owns the sprite store and the dirty tracking
+	// moves sprites to alpha of the way between the snapshot's two ticks and queues the ones that moved
+	void applySnapshot(const SimSnapshot& snapshot, float alpha);
+
+	// writes every sprite, returns the vertex count
 	int mapAll(Vertex* mapped);
+	// writes only the sprites that changed since this frame's buffer was last mapped,
+	// the written vertex ranges are appended to ranges. returns the total vertex count
+	int mapDirty(Vertex* mapped, uint32_t frame, std::vector<VertexRange>& ranges);
+	// same as mapDirty() but writes PackedVertex data
+	int mapDirtyPacked(PackedVertex* mapped, uint32_t frame, std::vector<VertexRange>& ranges);
+	// same as mapDirty() but one SpriteInstance per sprite, returns the instance count
+	int mapDirtyInstances(SpriteInstance* mapped, uint32_t frame, std::vector<VertexRange>& ranges);
+
+	int getVertexCount() const;
+
+	// how many buffers each change has to reach, one per frame in flight unless they share a single target
+	void setDirtyTargets(int targets);
+	// everything is rewritten on the next map of every target
+	void markAllDirty();
 
 	void scale();
-	void onKey();
 
 	void cleanup();
 
@@ -27,10 +55,25 @@ private:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
 	void generateWorld();
 
+	// dirty tracking, per sprite in the sprite store
+	// appends the merged dirty sprite ranges of frame (in sprite units) and clears them
+	void collectDirtyRanges(uint32_t frame, std::vector<VertexRange>& ranges);
+	void markDirty(int sprite);
+
 	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
 	GameState* gameState_ = nullptr;
 	AssetManager* assetManager_ = nullptr;
 
+	SpriteStore spriteStore_;
+
 	Player player_;
 	std::vector<Rectangle> rectangles_{};
-};
\ No newline at end of file
+	std::vector<Body> bodies_{};
+
+	// per sprite bitmask of frames whose buffer is out of date, and per frame list of those sprites.
+	// allDirtyFrames_ short-circuits the lists when everything changed (e.g. resize)
+	std::vector<uint8_t> dirtyFrames_{};
+	std::array<std::vector<int>, MAX_FRAMES_IN_FLIGHT> dirtySprites_{};
+	uint8_t allDirtyFrames_ = 0;
+	int dirtyTargets_ = MAX_FRAMES_IN_FLIGHT;
+};
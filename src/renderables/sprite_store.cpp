@@ -0,0 +1,225 @@
+#include "sprite_store.h"
+
+// SSE2 is always there on x64, AVX/F16C only when the build enables them (SPRITE_SEER_AVX2)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPRITE_STORE_SSE
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#define SPRITE_STORE_AVX
+#include <immintrin.h>
+#endif
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define SPRITE_STORE_F16C
+#include <immintrin.h>
+#endif
+
+/*
+-----~~~~~=====<<<<<{_KERNELS_}>>>>>=====~~~~~-----
+*/
+// out[i] = in[i] * factor
+static void multiplyKernel(const float* in, float* out, size_t count, float factor) {
+	size_t i = 0;
+#ifdef SPRITE_STORE_AVX
+	__m256 factor8 = _mm256_set1_ps(factor);
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(in + i), factor8));
+	}
+#endif
+#ifdef SPRITE_STORE_SSE
+	__m128 factor4 = _mm_set1_ps(factor);
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), factor4));
+	}
+#endif
+	for (; i < count; i++) {
+		out[i] = in[i] * factor;
+	}
+}
+
+// out[i] = a[i] + b[i]
+static void addKernel(const float* a, const float* b, float* out, size_t count) {
+	size_t i = 0;
+#ifdef SPRITE_STORE_AVX
+	for (; i + 8 <= count; i += 8) {
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+	}
+#endif
+#ifdef SPRITE_STORE_SSE
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	}
+#endif
+	for (; i < count; i++) {
+		out[i] = a[i] + b[i];
+	}
+}
+
+// out[i] = half(in[i])
+static void halfKernel(const float* in, uint16_t* out, size_t count) {
+	size_t i = 0;
+#ifdef SPRITE_STORE_F16C
+	for (; i + 8 <= count; i += 8) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+	}
+#endif
+	for (; i < count; i++) {
+		out[i] = glm::packHalf1x16(in[i]);
+	}
+}
+
+// the writers work through the sprites in batches so the far corners can be
+// computed with the kernels above into a small scratch area that stays in L1
+static const int WRITE_BATCH = 64;
+
+/*
+-----~~~~~=====<<<<<{_SPRITES_}>>>>>=====~~~~~-----
+*/
+int SpriteStore::add(const std::string& id, glm::vec2 position, glm::vec2 sizePercent, const TextureRegion& texture) {
+	posX_.push_back(position.x);
+	posY_.push_back(position.y);
+	sizeX_.push_back(sizePercent.x);
+	sizeY_.push_back(sizePercent.y);
+	extentX_.push_back(sizePercent.x * 2.f * spriteScale_);
+	extentY_.push_back(sizePercent.y * 2.f * spriteScale_);
+	// the image's rectangle on its atlas page
+	u0_.push_back(texture.uvRect.x);
+	v0_.push_back(texture.uvRect.y);
+	u1_.push_back(texture.uvRect.z);
+	v1_.push_back(texture.uvRect.w);
+	texIndex_.push_back(texture.page);
+	interaction_.push_back(0);
+
+	ids_.push_back(id);
+
+	return static_cast<int>(posX_.size()) - 1;
+}
+
+void SpriteStore::setPosition(int sprite, glm::vec2 position) {
+	posX_[sprite] = position.x;
+	posY_[sprite] = position.y;
+}
+
+void SpriteStore::setInteraction(int sprite, int interaction) { interaction_[sprite] = interaction; }
+
+int SpriteStore::getCount() const { return static_cast<int>(posX_.size()); }
+glm::vec2 SpriteStore::getPosition(int sprite) const { return { posX_[sprite], posY_[sprite] }; }
+const std::string& SpriteStore::getId(int sprite) const { return ids_[sprite]; }
+
+void SpriteStore::scale(float spriteScale) {
+	spriteScale_ = spriteScale;
+	multiplyKernel(sizeX_.data(), extentX_.data(), sizeX_.size(), 2.f * spriteScale_);
+	multiplyKernel(sizeY_.data(), extentY_.data(), sizeY_.size(), 2.f * spriteScale_);
+}
+
+/*
+-----~~~~~=====<<<<<{_WRITERS_}>>>>>=====~~~~~-----
+*/
+void SpriteStore::writeVertices(int first, int count, Vertex* out) const {
+	alignas(32) float x1[WRITE_BATCH];
+	alignas(32) float y1[WRITE_BATCH];
+
+	for (int batch = 0; batch < count; batch += WRITE_BATCH) {
+		int start = first + batch;
+		int n = std::min(WRITE_BATCH, count - batch);
+		addKernel(&posX_[start], &extentX_[start], x1, n);
+		addKernel(&posY_[start], &extentY_[start], y1, n);
+
+		for (int j = 0; j < n; j++) {
+			int i = start + j;
+			float x0 = posX_[i];
+			float y0 = posY_[i];
+
+			// top left, bottom left, top right, bottom right
+			Vertex* v = out + static_cast<size_t>(batch + j) * 4;
+#ifdef SPRITE_STORE_SSE
+			// pos and texCoord are the first 16 bytes of a Vertex
+			_mm_storeu_ps(&v[0].pos.x, _mm_setr_ps(x0, y0, u0_[i], v0_[i]));
+			_mm_storeu_ps(&v[1].pos.x, _mm_setr_ps(x0, y1[j], u0_[i], v1_[i]));
+			_mm_storeu_ps(&v[2].pos.x, _mm_setr_ps(x1[j], y0, u1_[i], v0_[i]));
+			_mm_storeu_ps(&v[3].pos.x, _mm_setr_ps(x1[j], y1[j], u1_[i], v1_[i]));
+#else
+			v[0].pos = { x0, y0 };
+			v[0].texCoord = { u0_[i], v0_[i] };
+			v[1].pos = { x0, y1[j] };
+			v[1].texCoord = { u0_[i], v1_[i] };
+			v[2].pos = { x1[j], y0 };
+			v[2].texCoord = { u1_[i], v0_[i] };
+			v[3].pos = { x1[j], y1[j] };
+			v[3].texCoord = { u1_[i], v1_[i] };
+#endif
+			for (int k = 0; k < 4; k++) {
+				v[k].texIndex = texIndex_[i];
+				v[k].interaction = interaction_[i];
+			}
+		}
+	}
+}
+
+void SpriteStore::writePackedVertices(int first, int count, PackedVertex* out) const {
+	alignas(32) float x1[WRITE_BATCH];
+	alignas(32) float y1[WRITE_BATCH];
+	alignas(32) uint16_t hx0[WRITE_BATCH];
+	alignas(32) uint16_t hy0[WRITE_BATCH];
+	alignas(32) uint16_t hx1[WRITE_BATCH];
+	alignas(32) uint16_t hy1[WRITE_BATCH];
+
+	for (int batch = 0; batch < count; batch += WRITE_BATCH) {
+		int start = first + batch;
+		int n = std::min(WRITE_BATCH, count - batch);
+		addKernel(&posX_[start], &extentX_[start], x1, n);
+		addKernel(&posY_[start], &extentY_[start], y1, n);
+		halfKernel(&posX_[start], hx0, n);
+		halfKernel(&posY_[start], hy0, n);
+		halfKernel(x1, hx1, n);
+		halfKernel(y1, hy1, n);
+
+		for (int j = 0; j < n; j++) {
+			int i = start + j;
+			uint16_t tu0 = glm::packUnorm1x16(u0_[i]);
+			uint16_t tv0 = glm::packUnorm1x16(v0_[i]);
+			uint16_t tu1 = glm::packUnorm1x16(u1_[i]);
+			uint16_t tv1 = glm::packUnorm1x16(v1_[i]);
+			uint32_t texIndexInteraction = (static_cast<uint32_t>(texIndex_[i]) & 0xFFFF) | (static_cast<uint32_t>(interaction_[i]) << 16);
+
+			// top left, bottom left, top right, bottom right
+			PackedVertex* v = out + static_cast<size_t>(batch + j) * 4;
+			v[0] = { { hx0[j], hy0[j] }, { tu0, tv0 }, texIndexInteraction };
+			v[1] = { { hx0[j], hy1[j] }, { tu0, tv1 }, texIndexInteraction };
+			v[2] = { { hx1[j], hy0[j] }, { tu1, tv0 }, texIndexInteraction };
+			v[3] = { { hx1[j], hy1[j] }, { tu1, tv1 }, texIndexInteraction };
+		}
+	}
+}
+
+void SpriteStore::writeInstances(int first, int count, SpriteInstance* out) const {
+	// a straight gather of the arrays, no arithmetic left to vectorize
+	for (int j = 0; j < count; j++) {
+		int i = first + j;
+		SpriteInstance& instance = out[j];
+		instance.pos = { posX_[i], posY_[i] };
+		instance.size = { extentX_[i], extentY_[i] };
+		instance.uvRect = { u0_[i], v0_[i], u1_[i], v1_[i] };
+		instance.texIndex = texIndex_[i];
+		instance.interaction = interaction_[i];
+	}
+}
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void SpriteStore::clear() {
+	posX_.clear();
+	posY_.clear();
+	sizeX_.clear();
+	sizeY_.clear();
+	extentX_.clear();
+	extentY_.clear();
+	u0_.clear();
+	v0_.clear();
+	u1_.clear();
+	v1_.clear();
+	texIndex_.clear();
+	interaction_.clear();
+	ids_.clear();
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../util.h"
+
+// structure of arrays holding everything the renderer needs per sprite.
+// hot per-sprite data sits in contiguous arrays so the vertex/instance writers
+// and the rescale can stream through them, string ids are kept apart as cold data
+class SpriteStore {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// returns the new sprite's index
+	int add(const std::string& id, glm::vec2 position, glm::vec2 sizePercent, const TextureRegion& texture);
+
+	void setPosition(int sprite, glm::vec2 position);
+	void setInteraction(int sprite, int interaction);
+
+	int getCount() const;
+	glm::vec2 getPosition(int sprite) const;
+	const std::string& getId(int sprite) const;
+
+	// recomputes every sprite's clip space extent for a new sprite scale
+	void scale(float spriteScale);
+
+	// write sprites [first, first + count) to out, out points at sprite first's data
+	void writeVertices(int first, int count, Vertex* out) const;
+	void writePackedVertices(int first, int count, PackedVertex* out) const;
+	void writeInstances(int first, int count, SpriteInstance* out) const;
+
+	void clear();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "SpriteStore::";
+
+private:
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	float spriteScale_ = 1.f;
+
+	// hot, one entry per sprite
+	std::vector<float> posX_{};
+	std::vector<float> posY_{};
+	std::vector<float> sizeX_{}; // percent of the screen
+	std::vector<float> sizeY_{};
+	std::vector<float> extentX_{}; // sizeX_ * 2 * spriteScale_, in clip space
+	std::vector<float> extentY_{};
+	std::vector<float> u0_{};
+	std::vector<float> v0_{};
+	std::vector<float> u1_{};
+	std::vector<float> v1_{};
+	std::vector<int32_t> texIndex_{}; // atlas page
+	std::vector<int32_t> interaction_{};
+
+	// cold
+	std::vector<std::string> ids_{};
+};
@@ -0,0 +1,118 @@
+#include "simulation.h"
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void Simulation::init(const EngineConfig& config, RenderableManager& renderableManager) {
+	log(name_ + __func__, "initializing simulation at " + std::to_string(config.simTickRate) + " Hz"
+		+ (config.simThread ? " on its own thread" : ""));
+
+	renderableManager_ = &renderableManager;
+	maxSteps_ = config.maxSimSteps;
+	tickSeconds_ = static_cast<float>(1.0 / config.simTickRate);
+	tickNs_ = static_cast<uint64_t>(1'000'000'000.0 / config.simTickRate);
+	simTimeNs_ = SDL_GetTicksNS();
+
+	// the renderer always has something to read
+	publish();
+
+	if (config.simThread) {
+		running_.store(true, std::memory_order_release);
+		thread_ = std::thread(&Simulation::threadLoop, this);
+	}
+}
+
+/*
+-----~~~~~=====<<<<<{_TICKS_}>>>>>=====~~~~~-----
+*/
+void Simulation::step() {
+	if (thread_.joinable()) {
+		return;
+	}
+	runDueTicks(SDL_GetTicksNS());
+}
+
+void Simulation::threadLoop() {
+	while (running_.load(std::memory_order_acquire)) {
+		runDueTicks(SDL_GetTicksNS());
+
+		// sleep until the next tick is due
+		uint64_t now = SDL_GetTicksNS();
+		uint64_t nextTick = simTimeNs_ + tickNs_;
+		if (nextTick > now) {
+			SDL_DelayNS(nextTick - now);
+		}
+	}
+}
+
+void Simulation::runDueTicks(uint64_t nowNs) {
+	int steps = 0;
+	while (simTimeNs_ + tickNs_ <= nowNs && steps < maxSteps_) {
+		// input since the last tick applies from this one on. a key pressed and released in between
+		// still counts as held for this tick, and is let go at the next one
+		uint32_t keys = keys_.load(std::memory_order_acquire) | pressedKeys_.exchange(0, std::memory_order_acq_rel);
+		if (keys != appliedKeys_) {
+			appliedKeys_ = keys;
+			renderableManager_->onKey(KeyState::unpack(keys));
+		}
+
+		renderableManager_->updateAll(tickSeconds_);
+		simTimeNs_ += tickNs_;
+		tick_++;
+		steps++;
+	}
+
+	// after a long hitch drop what could not be caught up instead of spiraling
+	if (simTimeNs_ + tickNs_ <= nowNs) {
+		simTimeNs_ = nowNs - (nowNs - simTimeNs_) % tickNs_;
+	}
+
+	if (steps > 0) {
+		publish();
+	}
+}
+
+void Simulation::publish() {
+	SimSnapshot& snapshot = snapshots_.getWriteBuffer();
+	renderableManager_->writeSnapshot(snapshot);
+	snapshot.tickEndNs = simTimeNs_;
+	snapshot.tick = tick_;
+	snapshots_.publish();
+}
+
+/*
+-----~~~~~=====<<<<<{_HANDOFF_}>>>>>=====~~~~~-----
+*/
+void Simulation::setKeys(const KeyState& keys) {
+	uint32_t bits = keys.pack();
+	// the held state is overwritten, presses are kept until a tick has seen them
+	pressedKeys_.fetch_or(bits, std::memory_order_release);
+	keys_.store(bits, std::memory_order_release);
+}
+
+const SimSnapshot& Simulation::acquireSnapshot() {
+	snapshots_.acquire();
+	return snapshots_.getReadBuffer();
+}
+
+float Simulation::getAlpha(const SimSnapshot& snapshot, uint64_t nowNs) const {
+	if (nowNs <= snapshot.tickEndNs) {
+		return 0.f;
+	}
+	return std::min(1.f, static_cast<float>(nowNs - snapshot.tickEndNs) / static_cast<float>(tickNs_));
+}
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void Simulation::cleanup() {
+	if (thread_.joinable()) {
+		log(name_ + __func__, "stopping simulation thread");
+		running_.store(false, std::memory_order_release);
+		thread_.join();
+	}
+}
+
+Simulation::~Simulation() {
+	cleanup();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <SDL3/SDL.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "util.h"
+#include "triple_buffer.h"
+#include "renderables/renderable_manager.h"
+
+// runs the fixed rate simulation ticks, either inline from mainLoop() or on its own thread,
+// and hands the results to the renderer as snapshots through a triple buffer
+class Simulation {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// starts the clock (and the thread with config.simThread), the scene has to be built by now
+	void init(const EngineConfig& config, RenderableManager& renderableManager);
+
+	// runs the ticks that are due, does nothing when the thread is running them
+	void step();
+
+	// main thread, picked up at the next tick (even if released again before it)
+	void setKeys(const KeyState& keys);
+
+	// render side: newest published snapshot, unchanged until the next call
+	const SimSnapshot& acquireSnapshot();
+	// how far nowNs is past the snapshot's last tick, in ticks, clamped to [0, 1]
+	float getAlpha(const SimSnapshot& snapshot, uint64_t nowNs) const;
+
+	// stops and joins the thread
+	void cleanup();
+	// a thread still running on an exception path would take the process down
+	~Simulation();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "Simulation::";
+
+private:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void threadLoop();
+	void runDueTicks(uint64_t nowNs);
+	void publish();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	RenderableManager* renderableManager_ = nullptr;
+
+	int maxSteps_ = 1;
+	float tickSeconds_ = 0.f;
+	uint64_t tickNs_ = 0;
+	// simulation side only: how far the simulation has got, in SDL_GetTicksNS time
+	uint64_t simTimeNs_ = 0;
+	uint64_t tick_ = 0;
+	uint32_t appliedKeys_ = 0;
+
+	// shared between threads
+	std::atomic<uint32_t> keys_{ 0 };
+	// every key seen down since the last tick, so taps shorter than a tick still reach it
+	std::atomic<uint32_t> pressedKeys_{ 0 };
+	std::atomic<bool> running_{ false };
+	TripleBuffer<SimSnapshot> snapshots_;
+
+	std::thread thread_;
+};
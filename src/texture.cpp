@@ -3,53 +3,92 @@
 /*
 -----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
 */
-void Texture::create(const std::string& filename, VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue) {
-	filename_ = filename.c_str();
+void Texture::readSize(const std::string& filename, int& width, int& height) {
+	int texChannels;
+	if (!stbi_info(filename.c_str(), &width, &height, &texChannels)) {
+		throw std::runtime_error("stbi_info() call failed for " + filename + ": " + std::string(stbi_failure_reason()));
+	}
+}
 
-	physicalDevice_ = physicalDevice;
-	device_ = device;
-	commandPool_ = commandPool;
-	graphicsQueue_ = graphicsQueue;
-	
-	// TEXTURE IMAGE ------------------------------====<
-	int texWidth, texHeight, texChannels;
-	stbi_uc* pixels = stbi_load(filename_, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = texWidth * texHeight * 4;
+DecodedImage Texture::decode(const std::string& filename) {
+	int texChannels;
+	DecodedImage image{};
+	stbi_uc* pixels = stbi_load(filename.c_str(), &image.width, &image.height, &texChannels, STBI_rgb_alpha);
 
 	if (!pixels) {
-		throw std::runtime_error("stbi_load() call failed: " + std::string(stbi_failure_reason()));
+		throw std::runtime_error("stbi_load() call failed for " + filename + ": " + std::string(stbi_failure_reason()));
 	}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMemory;
-	createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		stagingBuffer, stagingBufferMemory, device_, physicalDevice_);
+	image.sourceWidth = image.width;
+	image.sourceHeight = image.height;
+	image.pixels = std::shared_ptr<const uint8_t>(pixels, [](const uint8_t* p) { stbi_image_free(const_cast<uint8_t*>(p)); });
+	return image;
+}
 
-	void* data;
-	vkMapMemory(device_, stagingBufferMemory, 0, imageSize, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
-	vkUnmapMemory(device_, stagingBufferMemory);
+DecodedImage Texture::pad(const DecodedImage& image, int padding, int alignment) {
+	DecodedImage padded{};
+	padded.width = (image.width + 2 * padding + alignment - 1) / alignment * alignment;
+	padded.height = (image.height + 2 * padding + alignment - 1) / alignment * alignment;
+	padded.sourceWidth = image.sourceWidth;
+	padded.sourceHeight = image.sourceHeight;
+
+	uint8_t* pixels = new uint8_t[static_cast<size_t>(padded.width) * padded.height * 4];
+	const uint8_t* source = image.pixels.get();
+
+	// every destination pixel takes the nearest source pixel, so the gutter repeats the edges
+	for (int y = 0; y < padded.height; y++) {
+		int sourceY = std::clamp(y - padding, 0, image.height - 1);
+		const uint8_t* sourceRow = source + static_cast<size_t>(sourceY) * image.width * 4;
+		uint8_t* row = pixels + static_cast<size_t>(y) * padded.width * 4;
+
+		for (int x = 0; x < padding; x++) {
+			memcpy(row + x * 4, sourceRow, 4);
+		}
+		memcpy(row + padding * 4, sourceRow, static_cast<size_t>(image.width) * 4);
+		for (int x = padding + image.width; x < padded.width; x++) {
+			memcpy(row + x * 4, sourceRow + (image.width - 1) * 4, 4);
+		}
+	}
 
-	stbi_image_free(pixels);
+	padded.pixels = std::shared_ptr<const uint8_t>(pixels, std::default_delete<const uint8_t[]>());
+	return padded;
+}
 
-	createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_, imageMemory_,
-		device_, physicalDevice_);
+void Texture::create(const std::string& name, int width, int height, uint32_t maxMipLevels, VkPhysicalDevice physicalDevice, VkDevice device) {
+	textureName_ = name;
 
-	transitionImageLayout(image_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, device_, commandPool_, graphicsQueue_);
-	copyBufferToImage(stagingBuffer, image_, static_cast<uint32_t>(texWidth),
-		static_cast<uint32_t>(texHeight), device_, commandPool_, graphicsQueue_);
-	transitionImageLayout(image_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, device_, commandPool_, graphicsQueue_);
+	physicalDevice_ = physicalDevice;
+	device_ = device;
+
+	width_ = width;
+	height_ = height;
+
+	// MIP LEVELS ------------------------------====<
+	// down to 1x1 at most, and the chain is blitted on the GPU, which needs linear filtering of the format
+	uint32_t fullChain = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+	mipLevels_ = std::max(1u, std::min(maxMipLevels, fullChain));
+
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(physicalDevice_, VK_FORMAT_R8G8B8A8_SRGB, &formatProperties);
+	VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+	if (mipLevels_ > 1 && (formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures) {
+		log(name_ + __func__, "no linear blits for R8G8B8A8_SRGB, " + textureName_ + " gets no mip levels");
+		mipLevels_ = 1;
+	}
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (mipLevels_ > 1) {
+		// each level is blitted from the one above it
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	}
 
-	vkDestroyBuffer(device_, stagingBuffer, nullptr);
-	vkFreeMemory(device_, stagingBufferMemory, nullptr);
+	// TEXTURE IMAGE ------------------------------====<
+	createImage(width, height, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
+		usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image_, imageMemory_,
+		device_, physicalDevice_, mipLevels_);
 
 	// TEXTURE IMAGE VIEW ------------------------------====<
-	imageView_ = createImageView(image_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, device_);
+	imageView_ = createImageView(image_, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, device_, mipLevels_);
 
 	// TEXTURE IMAGE SAMPLER ------------------------------====<
 	VkPhysicalDeviceProperties properties{};
@@ -59,9 +98,10 @@ void Texture::create(const std::string& filename, VkPhysicalDevice physicalDevic
 	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
 	samplerInfo.magFilter = VK_FILTER_LINEAR;
 	samplerInfo.minFilter = VK_FILTER_LINEAR;
-	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	// atlas regions never wrap, and repeating would bleed the opposite edge of the page in
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
 	samplerInfo.anisotropyEnable = VK_FALSE;
 	samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy; // FIXME -> 1.0f
 	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
@@ -69,6 +109,9 @@ void Texture::create(const std::string& filename, VkPhysicalDevice physicalDevic
 	samplerInfo.compareEnable = VK_FALSE;
 	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.mipLodBias = 0.f;
+	samplerInfo.minLod = 0.f;
+	samplerInfo.maxLod = static_cast<float>(mipLevels_);
 
 	if (vkCreateSampler(device_, &samplerInfo, nullptr, &sampler_) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create texture sampler!");
@@ -78,6 +121,10 @@ void Texture::create(const std::string& filename, VkPhysicalDevice physicalDevic
 /*
 -----~~~~~=====<<<<<{_GETTERS_}>>>>>=====~~~~~-----
 */
+int Texture::getWidth() const { return width_; }
+int Texture::getHeight() const { return height_; }
+uint32_t Texture::getMipLevels() const { return mipLevels_; }
+const VkImage& Texture::getImage() const { return image_; }
 const VkImageView& Texture::getImageView() const { return imageView_; }
 const VkSampler& Texture::getSampler() const { return sampler_; }
 
@@ -85,7 +132,7 @@ const VkSampler& Texture::getSampler() const { return sampler_; }
 -----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
 */
 void Texture::destroy() {
-	log(name_ + __func__, "destroying vulkan texture objects");
+	log(name_ + __func__, "destroying vulkan texture objects for " + textureName_);
 
 	// CLEANUP TEXTURE stuff
 	vkDestroySampler(device_, sampler_, nullptr);
@@ -3,14 +3,29 @@
 #include <vulkan/vulkan.h>
 
 #include <string>
+#include <cmath>
 
 #include "util.h"
 
 class Texture {
 public:
 	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
-	void create(const std::string& filename, VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue);
-
+	// stb_image header only, for sizing the upload before anything is decoded
+	static void readSize(const std::string& filename, int& width, int& height);
+	// stb_image decode, touches no Vulkan state so it can run on any thread
+	static DecodedImage decode(const std::string& filename);
+	// copy with a border of padding pixels repeating the edge, for packing into an atlas. the right and
+	// bottom border grow further until the padded size is a multiple of alignment
+	static DecodedImage pad(const DecodedImage& image, int padding, int alignment = 1);
+	// image, view and sampler with up to maxMipLevels levels (fewer for small images, or 1 when the device
+	// cannot blit the format with linear filtering). the pixels come later through an UploadBatcher, which
+	// fills the mip chain and leaves the image SHADER_READ_ONLY
+	void create(const std::string& name, int width, int height, uint32_t maxMipLevels, VkPhysicalDevice physicalDevice, VkDevice device);
+
+	int getWidth() const;
+	int getHeight() const;
+	uint32_t getMipLevels() const;
+	const VkImage& getImage() const;
 	const VkImageView& getImageView() const;
 	const VkSampler& getSampler() const;
 
@@ -24,16 +39,17 @@ private:
 	//
 
 	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
-	// name of picture file
-	const char* filename_;
+	// picture file or atlas page
+	std::string textureName_;
 
 	// references to vk stuff
 	VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
 	VkDevice device_ = VK_NULL_HANDLE;
-	VkCommandPool commandPool_ = VK_NULL_HANDLE;
-	VkQueue graphicsQueue_ = VK_NULL_HANDLE;
 
 	// TEXTURE STUFF
+	int width_ = 0;
+	int height_ = 0;
+	uint32_t mipLevels_ = 1;
 	VkImage image_ = VK_NULL_HANDLE;
 	VkDeviceMemory imageMemory_ = VK_NULL_HANDLE;
 	VkImageView imageView_ = VK_NULL_HANDLE;
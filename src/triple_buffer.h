@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// lock-free single producer / single consumer handoff of the latest value.
+// the writer fills its back slot and publishes it, the reader takes whatever was
+// published last. neither side ever waits and stale values are simply skipped
+template <typename T>
+class TripleBuffer {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// writer side, the slot is the writer's own until publish()
+	T& getWriteBuffer() { return buffers_[back_]; }
+
+	void publish() {
+		// swap back with the middle slot and flag it as new
+		uint8_t previous = middle_.exchange(back_ | FRESH_BIT, std::memory_order_acq_rel);
+		back_ = previous & INDEX_MASK;
+	}
+
+	// reader side, takes the newest published slot. returns false if nothing new was published
+	bool acquire() {
+		if (!(middle_.load(std::memory_order_acquire) & FRESH_BIT)) {
+			return false;
+		}
+		uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+		front_ = previous & INDEX_MASK;
+		return true;
+	}
+
+	// stays valid and unchanged until the next acquire()
+	const T& getReadBuffer() const { return buffers_[front_]; }
+
+private:
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	static const uint8_t INDEX_MASK = 0x3;
+	static const uint8_t FRESH_BIT = 0x4;
+
+	std::array<T, 3> buffers_{};
+	uint8_t back_ = 0; // writer only
+	uint8_t front_ = 1; // reader only
+	std::atomic<uint8_t> middle_{ 2 };
+};
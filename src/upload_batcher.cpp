@@ -0,0 +1,214 @@
+#include "upload_batcher.h"
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void UploadBatcher::begin(VkDeviceSize stagingSize, VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue) {
+	log(name_ + __func__, "starting upload batch, " + std::to_string(stagingSize) + " staging bytes");
+
+	device_ = device;
+	commandPool_ = commandPool;
+	graphicsQueue_ = graphicsQueue;
+
+	// STAGING BUFFER ------------------------------====<
+	// one buffer for the whole batch, mapped until submit()
+	stagingSize_ = std::max<VkDeviceSize>(stagingSize, 1);
+	stagingOffset_ = 0;
+	createBuffer(stagingSize_, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer_, stagingBufferMemory_, device_, physicalDevice);
+
+	void* mapped;
+	vkMapMemory(device_, stagingBufferMemory_, 0, stagingSize_, 0, &mapped);
+	stagingMapped_ = static_cast<uint8_t*>(mapped);
+
+	// COMMAND BUFFER + FENCE ------------------------------====<
+	VkCommandBufferAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandPool = commandPool_;
+	allocInfo.commandBufferCount = 1;
+
+	if (vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer_) != VK_SUCCESS) {
+		throw std::runtime_error("failed to allocate upload command buffer!");
+	}
+
+	VkFenceCreateInfo fenceInfo{};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+	if (vkCreateFence(device_, &fenceInfo, nullptr, &fence_) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create upload fence!");
+	}
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	if (vkBeginCommandBuffer(commandBuffer_, &beginInfo) != VK_SUCCESS) {
+		throw std::runtime_error("failed to begin recording upload command buffer!");
+	}
+
+	targets_.clear();
+}
+
+/*
+-----~~~~~=====<<<<<{_RECORDING_}>>>>>=====~~~~~-----
+*/
+void UploadBatcher::addTarget(VkImage image, int width, int height, uint32_t mipLevels) {
+	// UNDEFINED -> TRANSFER_DST, every level: 0 is copied into, the rest are blitted into
+	VkImageMemoryBarrier barrier = layoutBarrier(image, 0, mipLevels, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		0, VK_ACCESS_TRANSFER_WRITE_BIT);
+	vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	targets_.push_back({ image, width, height, mipLevels });
+}
+
+void UploadBatcher::addImage(VkImage image, const DecodedImage& decoded, int32_t x, int32_t y) {
+	if (std::find_if(targets_.begin(), targets_.end(), [&](const Target& target) { return target.image == image; }) == targets_.end()) {
+		throw std::runtime_error("upload batch image was not added as a target!");
+	}
+
+	VkDeviceSize imageSize = static_cast<VkDeviceSize>(decoded.width) * decoded.height * 4;
+	if (stagingOffset_ + imageSize > stagingSize_) {
+		throw std::runtime_error("upload batch staging buffer is too small!");
+	}
+
+	memcpy(stagingMapped_ + stagingOffset_, decoded.pixels.get(), static_cast<size_t>(imageSize));
+
+	// copies into different regions of one image need no barrier between them
+	VkBufferImageCopy region{};
+	region.bufferOffset = stagingOffset_;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageOffset = { x, y, 0 };
+	region.imageExtent = { static_cast<uint32_t>(decoded.width), static_cast<uint32_t>(decoded.height), 1 };
+
+	vkCmdCopyBufferToImage(commandBuffer_, stagingBuffer_, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	stagingOffset_ += getStagingSize(decoded.width, decoded.height);
+}
+
+void UploadBatcher::submit() {
+	log(name_ + __func__, "submitting uploads into " + std::to_string(targets_.size()) + " images");
+
+	// MIP CHAINS ------------------------------====<
+	// level by level across every target, so each step is one barrier: the finished level above becomes
+	// TRANSFER_SRC and is blitted (linear, half size) into the next. the last level stays TRANSFER_DST
+	uint32_t mipLevels = 1;
+	for (const Target& target : targets_) {
+		mipLevels = std::max(mipLevels, target.mipLevels);
+	}
+
+	for (uint32_t level = 1; level < mipLevels; level++) {
+		std::vector<VkImageMemoryBarrier> barriers{};
+		for (const Target& target : targets_) {
+			if (level < target.mipLevels) {
+				barriers.push_back(layoutBarrier(target.image, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+					VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT));
+			}
+		}
+		vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+
+		for (const Target& target : targets_) {
+			if (level >= target.mipLevels) {
+				continue;
+			}
+
+			VkImageBlit blit{};
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.srcOffsets[0] = { 0, 0, 0 };
+			blit.srcOffsets[1] = { std::max(target.width >> (level - 1), 1), std::max(target.height >> (level - 1), 1), 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+			blit.dstOffsets[0] = { 0, 0, 0 };
+			blit.dstOffsets[1] = { std::max(target.width >> level, 1), std::max(target.height >> level, 1), 1 };
+
+			vkCmdBlitImage(commandBuffer_, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				target.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+		}
+	}
+
+	// every level -> SHADER_READ_ONLY in one barrier
+	std::vector<VkImageMemoryBarrier> barriers{};
+	for (const Target& target : targets_) {
+		uint32_t last = target.mipLevels - 1;
+		if (last > 0) {
+			barriers.push_back(layoutBarrier(target.image, 0, last, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT));
+		}
+		barriers.push_back(layoutBarrier(target.image, last, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT));
+	}
+
+	if (!barriers.empty()) {
+		vkCmdPipelineBarrier(commandBuffer_, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+	}
+
+	if (vkEndCommandBuffer(commandBuffer_) != VK_SUCCESS) {
+		throw std::runtime_error("failed to record upload command buffer!");
+	}
+
+	VkSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer_;
+
+	if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence_) != VK_SUCCESS) {
+		throw std::runtime_error("failed to submit upload command buffer!");
+	}
+	vkWaitForFences(device_, 1, &fence_, VK_TRUE, UINT64_MAX);
+
+	// CLEANUP ------------------------------====<
+	vkDestroyFence(device_, fence_, nullptr);
+	vkFreeCommandBuffers(device_, commandPool_, 1, &commandBuffer_);
+	vkUnmapMemory(device_, stagingBufferMemory_);
+	vkDestroyBuffer(device_, stagingBuffer_, nullptr);
+	vkFreeMemory(device_, stagingBufferMemory_, nullptr);
+
+	fence_ = VK_NULL_HANDLE;
+	commandBuffer_ = VK_NULL_HANDLE;
+	stagingBuffer_ = VK_NULL_HANDLE;
+	stagingBufferMemory_ = VK_NULL_HANDLE;
+	stagingMapped_ = nullptr;
+	targets_.clear();
+}
+
+VkImageMemoryBarrier UploadBatcher::layoutBarrier(VkImage image, uint32_t baseMipLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+	VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask) {
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = baseMipLevel;
+	barrier.subresourceRange.levelCount = levelCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+	barrier.srcAccessMask = srcAccessMask;
+	barrier.dstAccessMask = dstAccessMask;
+	return barrier;
+}
+
+/*
+-----~~~~~=====<<<<<{_GETTERS_}>>>>>=====~~~~~-----
+*/
+VkDeviceSize UploadBatcher::getStagingSize(int width, int height) {
+	// copy offsets have to be a multiple of the 4 byte texel size, 16 covers that
+	VkDeviceSize size = static_cast<VkDeviceSize>(width) * height * 4;
+	return (size + 15) & ~static_cast<VkDeviceSize>(15);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+#include "util.h"
+
+// uploads a batch of images through one staging buffer and one command buffer:
+// every copy is recorded as its pixels are added, the mip chains are blitted from them at the end,
+// then the whole batch is submitted once and waited on with a single fence
+class UploadBatcher {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	// stagingSize has to cover every image added before submit(), see getStagingSize()
+	void begin(VkDeviceSize stagingSize, VkPhysicalDevice physicalDevice, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue);
+
+	// an image to upload into, taken from UNDEFINED to TRANSFER_DST. with more than one mip level
+	// submit() fills the rest of the chain from level 0
+	void addTarget(VkImage image, int width, int height, uint32_t mipLevels = 1);
+	// copies the pixels into the staging buffer and records the transfer to (x, y) of a target, mip 0.
+	// several regions can share one target
+	void addImage(VkImage image, const DecodedImage& decoded, int32_t x = 0, int32_t y = 0);
+
+	// blits the mip chains, moves every target to SHADER_READ_ONLY, submits, waits on the fence, frees the staging buffer
+	void submit();
+
+	// staging bytes one image takes up, offset alignment included
+	static VkDeviceSize getStagingSize(int width, int height);
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "UploadBatcher::";
+
+private:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	static VkImageMemoryBarrier layoutBarrier(VkImage image, uint32_t baseMipLevel, uint32_t levelCount, VkImageLayout oldLayout, VkImageLayout newLayout,
+		VkAccessFlags srcAccessMask, VkAccessFlags dstAccessMask);
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	struct Target {
+		VkImage image;
+		int width;
+		int height;
+		uint32_t mipLevels;
+	};
+
+	// references to vk stuff
+	VkDevice device_ = VK_NULL_HANDLE;
+	VkCommandPool commandPool_ = VK_NULL_HANDLE;
+	VkQueue graphicsQueue_ = VK_NULL_HANDLE;
+
+	VkBuffer stagingBuffer_ = VK_NULL_HANDLE;
+	VkDeviceMemory stagingBufferMemory_ = VK_NULL_HANDLE;
+	uint8_t* stagingMapped_ = nullptr;
+	VkDeviceSize stagingSize_ = 0;
+	VkDeviceSize stagingOffset_ = 0;
+
+	VkCommandBuffer commandBuffer_ = VK_NULL_HANDLE;
+	VkFence fence_ = VK_NULL_HANDLE;
+
+	// images copied into, they get their mip chains and final transition at submit()
+	std::vector<Target> targets_{};
+};
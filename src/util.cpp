@@ -10,6 +10,194 @@ void log(const std::string& src, const std::string& msg) {
     std::cout << output.str();
 }
 
+std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        unsigned char code = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        }
+        else if (code < 0x20) {
+            // control characters are not allowed raw inside a JSON string
+            char hex[7];
+            std::snprintf(hex, sizeof(hex), "\\u%04x", code);
+            escaped += hex;
+        }
+        else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+EngineConfig parseArgs(int argc, char** argv) {
+    EngineConfig config{};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--instanced") {
+            config.instancedSprites = true;
+        }
+        else if (arg == "--packed-vertices") {
+            config.packedVertices = true;
+        }
+        else if (arg == "--device-local") {
+            config.deviceLocalVertices = true;
+        }
+        else if (arg == "--fps" && i + 1 < argc) {
+            config.targetFps = std::stod(argv[++i]);
+        }
+        else if (arg == "--headless") {
+            config.headless = true;
+        }
+        else if (arg == "--frames" && i + 1 < argc) {
+            config.frameCount = std::stoull(argv[++i]);
+        }
+        else if (arg == "--bench" && i + 1 < argc) {
+            config.benchThousands = std::stoi(argv[++i]);
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            config.benchSeed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (arg == "--bench-report" && i + 1 < argc) {
+            config.benchReport = argv[++i];
+        }
+        else if (arg == "--tick-rate" && i + 1 < argc) {
+            config.simTickRate = std::stod(argv[++i]);
+        }
+        else if (arg == "--max-sim-steps" && i + 1 < argc) {
+            config.maxSimSteps = std::stoi(argv[++i]);
+        }
+        else if (arg == "--sim-thread") {
+            config.simThread = true;
+        }
+        else if (arg == "--record-threads" && i + 1 < argc) {
+            config.recordThreads = std::stoi(argv[++i]);
+        }
+        else if (arg == "--frames-in-flight" && i + 1 < argc) {
+            config.framesInFlight = std::stoi(argv[++i]);
+        }
+        else if (arg == "--late-input") {
+            config.lateInput = true;
+        }
+        else if (arg == "--pixel-cache" && i + 1 < argc) {
+            config.pixelCache = argv[++i];
+        }
+        else if (arg == "--no-pixel-cache") {
+            config.pixelCache.clear();
+        }
+        else if (arg == "--present" && i + 1 < argc) {
+            std::string policy = argv[++i];
+            auto found = std::find(PRESENT_POLICY_NAMES.begin(), PRESENT_POLICY_NAMES.end(), policy);
+            if (found == PRESENT_POLICY_NAMES.end()) {
+                throw std::runtime_error("unknown present policy: " + policy);
+            }
+            config.presentPolicy = static_cast<PresentPolicy>(found - PRESENT_POLICY_NAMES.begin());
+        }
+        else {
+            throw std::runtime_error("unknown command line option: " + arg);
+        }
+    }
+
+    if (config.simTickRate <= 0.0 || config.maxSimSteps < 1) {
+        throw std::runtime_error("--tick-rate and --max-sim-steps have to be positive");
+    }
+
+    if (config.framesInFlight < 1 || config.framesInFlight > MAX_FRAMES_IN_FLIGHT) {
+        throw std::runtime_error("--frames-in-flight has to be between 1 and " + std::to_string(MAX_FRAMES_IN_FLIGHT));
+    }
+
+    // a benchmark always has an end
+    if (config.benchThousands > 0 && config.frameCount == 0) {
+        config.frameCount = BENCH_DEFAULT_FRAMES;
+    }
+
+    return config;
+}
+
+uint32_t KeyState::pack() const {
+    return (w << 0) | (a << 1) | (s << 2) | (d << 3) | (space << 4) | (shift << 5) | (ctrl << 6);
+}
+
+KeyState KeyState::unpack(uint32_t bits) {
+    KeyState keys{};
+    keys.w = bits & (1 << 0);
+    keys.a = bits & (1 << 1);
+    keys.s = bits & (1 << 2);
+    keys.d = bits & (1 << 3);
+    keys.space = bits & (1 << 4);
+    keys.shift = bits & (1 << 5);
+    keys.ctrl = bits & (1 << 6);
+    return keys;
+}
+
+float randomFloat(std::mt19937& rng) {
+    // top 24 bits, exactly representable as a float
+    return static_cast<float>(rng() >> 8) * (1.f / 16777216.f);
+}
+
+/*
+-----~~~~~=====<<<<<{_VERTEX_LAYOUT_}>>>>>=====~~~~~-----
+*/
+VkVertexInputBindingDescription Vertex::getBindingDescription(VertexFormat format) {
+    VkVertexInputBindingDescription bindingDescription{};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = (format == VERTEX_FORMAT_PACKED) ? sizeof(PackedVertex) : sizeof(Vertex);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return bindingDescription;
+}
+
+std::vector<VkVertexInputAttributeDescription> Vertex::getAttributeDescriptions(VertexFormat format) {
+    if (format == VERTEX_FORMAT_PACKED) {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
+
+        attributeDescriptions[0].binding = 0;
+        attributeDescriptions[0].location = 0;
+        attributeDescriptions[0].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(PackedVertex, pos);
+
+        attributeDescriptions[1].binding = 0;
+        attributeDescriptions[1].location = 1;
+        attributeDescriptions[1].format = VK_FORMAT_R16G16_UNORM;
+        attributeDescriptions[1].offset = offsetof(PackedVertex, texCoord);
+
+        attributeDescriptions[2].binding = 0;
+        attributeDescriptions[2].location = 2;
+        attributeDescriptions[2].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[2].offset = offsetof(PackedVertex, texIndexInteraction);
+
+        return attributeDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
+
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[0].offset = offsetof(Vertex, pos);
+
+    attributeDescriptions[1].binding = 0;
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
+    attributeDescriptions[1].offset = offsetof(Vertex, texCoord);
+
+    attributeDescriptions[2].binding = 0;
+    attributeDescriptions[2].location = 2;
+    attributeDescriptions[2].format = VK_FORMAT_R32_SINT;
+    attributeDescriptions[2].offset = offsetof(Vertex, texIndex);
+
+    attributeDescriptions[3].binding = 0;
+    attributeDescriptions[3].location = 3;
+    attributeDescriptions[3].format = VK_FORMAT_R32_SINT;
+    attributeDescriptions[3].offset = offsetof(Vertex, interaction);
+
+    return attributeDescriptions;
+}
+
 /*
 -----~~~~~=====<<<<<{_VULKAN_HELPER_METHODS_}>>>>>=====~~~~~-----
 */
@@ -35,8 +223,9 @@ bool isDeviceSuitable(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, con
 
     bool extensionsSupported = checkDeviceExtensionSupport(physicalDevice, deviceExtensions);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    // headless, nothing to present to
+    bool swapChainAdequate = surface == VK_NULL_HANDLE;
+    if (extensionsSupported && !swapChainAdequate) {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(physicalDevice, surface);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
@@ -62,8 +251,11 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceK
             indices.graphicsFamily = i;
         }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+        // without a surface (headless) nothing is presented, the graphics queue stands in
+        VkBool32 presentSupport = surface == VK_NULL_HANDLE && (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+        if (surface != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
+        }
 
         if (presentSupport) {
             indices.presentFamily = i;
@@ -96,6 +288,22 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, const std::vec
     return requiredExtensions.empty();
 }
 
+bool checkInstanceExtensionSupport(const std::vector<const char*>& instanceExtensions) {
+    uint32_t extensionCount;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+
+    std::set<std::string> requiredExtensions(instanceExtensions.begin(), instanceExtensions.end());
+
+    for (const auto& extension : availableExtensions) {
+        requiredExtensions.erase(extension.extensionName);
+    }
+
+    return requiredExtensions.empty();
+}
+
 
 /*
 -----~~~~~=====<<<<<{_SWAPCHAIN_}>>>>>=====~~~~~-----
@@ -134,16 +342,38 @@ VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>
     return availableFormats[0];
 }
 
-VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-    for (const auto& availablePresentMode : availablePresentModes) {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            return availablePresentMode;
+VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, PresentPolicy policy) {
+    std::vector<VkPresentModeKHR> preferred{};
+    switch (policy) {
+    case PRESENT_POLICY_LOW_LATENCY:
+        preferred = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+        break;
+    case PRESENT_POLICY_ADAPTIVE:
+        preferred = { VK_PRESENT_MODE_FIFO_RELAXED_KHR };
+        break;
+    default: break;
+    }
+
+    for (VkPresentModeKHR presentMode : preferred) {
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), presentMode) != availablePresentModes.end()) {
+            return presentMode;
         }
     }
 
+    // always supported
     return VK_PRESENT_MODE_FIFO_KHR;
 }
 
+std::string getPresentModeName(VkPresentModeKHR presentMode) {
+    switch (presentMode) {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+    case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+    case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+    default: return std::to_string(presentMode);
+    }
+}
+
 VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, SDL_Window* window) {
     if (capabilities.currentExtent.width != std::numeric_limits<uint32_t>::max()) {
         return capabilities.currentExtent;
@@ -186,7 +416,7 @@ VkFormat findDepthFormat(const VkPhysicalDevice& physicalDevice) {
 /*
 -----~~~~~=====<<<<<{_IMAGE_}>>>>>=====~~~~~-----
 */
-VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkDevice& device) {
+VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkDevice& device, uint32_t mipLevels) {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = image;
@@ -194,7 +424,7 @@ VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags a
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
@@ -207,14 +437,15 @@ VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags a
 }
 
 void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage,
-    VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkDevice& device, VkPhysicalDevice& physicalDevice) {
+    VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkDevice& device, VkPhysicalDevice& physicalDevice,
+    uint32_t mipLevels) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType = VK_IMAGE_TYPE_2D;
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
@@ -321,7 +552,28 @@ uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, c
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
-void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory, const VkDevice& device, const VkPhysicalDevice& physicalDevice) {
+// the memory type through which the CPU can map a large device local heap, if there is one. without resizable
+// BAR only a 256 MiB window is host visible, which the driver keeps for itself, so that does not count.
+// allocate from exactly this type, findMemoryType() may hand out the small window when it is listed first
+std::optional<uint32_t> findResizableBarMemoryType(const VkPhysicalDevice& physicalDevice) {
+    const VkDeviceSize barWindowSize = 256ull * 1024 * 1024;
+    const VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        const VkMemoryType& type = memProperties.memoryTypes[i];
+        if ((type.propertyFlags & properties) == properties && memProperties.memoryHeaps[type.heapIndex].size > barWindowSize) {
+            return i;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory, const VkDevice& device, const VkPhysicalDevice& physicalDevice,
+    std::optional<uint32_t> memoryTypeIndex) {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
@@ -338,7 +590,15 @@ void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyF
     VkMemoryAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
     allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties, physicalDevice);
+    if (memoryTypeIndex.has_value()) {
+        if (!(memRequirements.memoryTypeBits & (1u << *memoryTypeIndex))) {
+            throw std::runtime_error("buffer cannot live in the requested memory type!");
+        }
+        allocInfo.memoryTypeIndex = *memoryTypeIndex;
+    }
+    else {
+        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties, physicalDevice);
+    }
 
     if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate buffer memory!");
@@ -4,6 +4,7 @@
 
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
 #include <SDL3/SDL.h>
 
 #include <optional>
@@ -13,11 +14,14 @@
 #include <array>
 #include <algorithm>
 #include <chrono>
+#include <random>
+#include <memory>
 
 #include <iostream>
 #include <set>
 #include <sstream>
 #include <fstream>
+#include <cstdio>
 
 // -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
 // TYPES and GLOBALS
@@ -32,9 +36,36 @@ const bool enableValidationLayers = true;
 const int FPS_MEASURE_INTERVAL = 500;
 const uint32_t WIDTH = 1600;
 const uint32_t HEIGHT = 800;
-const int MAX_FRAMES_IN_FLIGHT = 2;
-const int MAX_QUADS = 2048;
-const int MAX_LINES = 256;
+// longest one vkWaitForPresentKHR call holds the swapchain, acquire and present wait at most this long for it
+const uint64_t PRESENT_WAIT_SLICE_NS = 250000;
+// frames the CPU may record ahead of the GPU, --frames-in-flight picks one up to the cap
+const int DEFAULT_FRAMES_IN_FLIGHT = 2;
+const int MAX_FRAMES_IN_FLIGHT = 4;
+// color format of the render targets that replace the swapchain with --headless
+const VkFormat OFFSCREEN_COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+// starting sizes of the geometry buffers, they grow as the scene needs
+const int INITIAL_QUAD_CAPACITY = 256;
+const int INITIAL_LINE_CAPACITY = 256;
+// texture atlas pages images are packed into at load time (capped by maxImageDimension2D), and the
+// gutter around every image, filled with its edge pixels so filtering never picks up a neighbour.
+// pages get up to ATLAS_MIP_LEVELS mip levels: every padded image is placed at and sized to a multiple of
+// ATLAS_ALIGNMENT texels, so no texel of the smallest level mixes two images, and the gutter is still a texel wide there
+const int ATLAS_PAGE_SIZE = 2048;
+const int ATLAS_MIP_LEVELS = 4;
+const int ATLAS_ALIGNMENT = 1 << (ATLAS_MIP_LEVELS - 1);
+const int ATLAS_PADDING = ATLAS_ALIGNMENT;
+// decoded pixel cache file layout (see PixelCache), a version bump invalidates old caches
+const char PIXEL_CACHE_MAGIC[4] = { 'S', 'S', 'P', 'C' };
+const uint32_t PIXEL_CACHE_VERSION = 2;
+const size_t PIXEL_CACHE_ALIGNMENT = 16;
+// frame limits the -/= keys step through, 0 = uncapped
+const std::array<double, 6> FRAME_LIMIT_PRESETS = { 0.0, 30.0, 60.0, 120.0, 144.0, 240.0 };
+// frame time histograms, 10 us buckets up to 50 ms
+const double HISTOGRAM_BUCKET_US = 10.0;
+const size_t HISTOGRAM_BUCKETS = 5000;
+// --bench scene, every BENCH_BODY_INTERVAL-th generated sprite moves
+const uint64_t BENCH_DEFAULT_FRAMES = 2000;
+const int BENCH_BODY_INTERVAL = 8;
 const float PLAYER_ACCELERATION = 1.f; 
 const float PLAYER_DECELERATION = 3.f;
 const float PLAYER_GRAVITY = 50.f;
@@ -45,9 +76,39 @@ const float MAX_PLAYER_VELOCITY = 3.f;
 // GAME VARIABLES
 
 const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME };
+// no surface to present to, so no swapchain
+const std::vector<const char*> headlessDeviceExtensions = { VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME };
+// enabled when the device has both, input to present latency is only measured with them
+const std::vector<const char*> presentWaitDeviceExtensions = { VK_KHR_PRESENT_ID_EXTENSION_NAME, VK_KHR_PRESENT_WAIT_EXTENSION_NAME };
+// swapchain_maintenance1 gives every present a fence, retired swapchains are only destroyed once those signal
+const std::vector<const char*> swapchainMaintenanceInstanceExtensions = { VK_KHR_GET_SURFACE_CAPABILITIES_2_EXTENSION_NAME, VK_EXT_SURFACE_MAINTENANCE_1_EXTENSION_NAME };
+const std::vector<const char*> swapchainMaintenanceDeviceExtensions = { VK_EXT_SWAPCHAIN_MAINTENANCE_1_EXTENSION_NAME };
 
 const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
 
+// vertex layouts the quad pipeline can be fed with
+typedef enum VertexFormat {
+    VERTEX_FORMAT_FULL = 0, // Vertex, 24 bytes
+    VERTEX_FORMAT_PACKED = 1, // PackedVertex, 12 bytes
+} VertexFormat;
+
+// where the sprite geometry the GPU reads from lives
+typedef enum SpriteMemory {
+    SPRITE_MEMORY_HOST = 0, // host visible ring, read by the GPU over the bus
+    SPRITE_MEMORY_STAGED = 1, // one device local buffer, fed from the ring with vkCmdCopyBuffer
+    SPRITE_MEMORY_REBAR = 2, // host visible ring in device local memory (resizable BAR / UMA)
+} SpriteMemory;
+
+// latency vs power tradeoff of the swapchain, each policy walks its own present mode list
+// and FIFO, the one mode every device has, ends all of them
+typedef enum PresentPolicy {
+    PRESENT_POLICY_LOW_LATENCY = 0, // MAILBOX, IMMEDIATE (tears), FIFO
+    PRESENT_POLICY_POWER_SAVING = 1, // FIFO
+    PRESENT_POLICY_ADAPTIVE = 2, // FIFO_RELAXED (tears when a frame is late), FIFO
+    PRESENT_POLICY_COUNT = 3,
+} PresentPolicy;
+const std::array<const char*, PRESENT_POLICY_COUNT> PRESENT_POLICY_NAMES = { "low-latency", "power-saving", "adaptive" };
+
 // vertex data structure
 struct Vertex {
     glm::vec2 pos;
@@ -55,44 +116,85 @@ struct Vertex {
     int texIndex;
     int interaction;
 
+    static VkVertexInputBindingDescription getBindingDescription(VertexFormat format = VERTEX_FORMAT_FULL);
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions(VertexFormat format = VERTEX_FORMAT_FULL);
+
+    bool operator==(const Vertex& other) const {
+        return pos == other.pos && texCoord == other.texCoord && texIndex == other.texIndex && other.interaction == other.interaction;
+    }
+};
+
+// compact vertex: half float position, 16 bit unorm tex coords, texIndex (low 16 bits) and
+// interaction (high 16 bits) in one uint. read by main_packed.vert
+struct PackedVertex {
+    uint16_t pos[2];
+    uint16_t texCoord[2];
+    uint32_t texIndexInteraction;
+
+    static PackedVertex pack(const Vertex& vertex) {
+        PackedVertex packed;
+        packed.pos[0] = glm::packHalf1x16(vertex.pos.x);
+        packed.pos[1] = glm::packHalf1x16(vertex.pos.y);
+        packed.texCoord[0] = glm::packUnorm1x16(vertex.texCoord.x);
+        packed.texCoord[1] = glm::packUnorm1x16(vertex.texCoord.y);
+        packed.texIndexInteraction = (static_cast<uint32_t>(vertex.texIndex) & 0xFFFF) | (static_cast<uint32_t>(vertex.interaction) << 16);
+        return packed;
+    }
+};
+
+// per sprite record for the instanced draw path, main_instanced.vert expands it into a quad
+struct SpriteInstance {
+    glm::vec2 pos; // top left corner
+    glm::vec2 size;
+    glm::vec4 uvRect; // u0, v0, u1, v1
+    int texIndex;
+    int interaction;
+
     static VkVertexInputBindingDescription getBindingDescription() {
         VkVertexInputBindingDescription bindingDescription{};
         bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Vertex);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindingDescription.stride = sizeof(SpriteInstance);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
 
         return bindingDescription;
     }
 
-    static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions{};
+    static std::array<VkVertexInputAttributeDescription, 5> getAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions{};
 
         attributeDescriptions[0].binding = 0;
         attributeDescriptions[0].location = 0;
         attributeDescriptions[0].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Vertex, pos);
+        attributeDescriptions[0].offset = offsetof(SpriteInstance, pos);
 
         attributeDescriptions[1].binding = 0;
         attributeDescriptions[1].location = 1;
         attributeDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Vertex, texCoord);
+        attributeDescriptions[1].offset = offsetof(SpriteInstance, size);
 
         attributeDescriptions[2].binding = 0;
         attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = VK_FORMAT_R32_SINT;
-        attributeDescriptions[2].offset = offsetof(Vertex, texIndex);
+        attributeDescriptions[2].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        attributeDescriptions[2].offset = offsetof(SpriteInstance, uvRect);
 
         attributeDescriptions[3].binding = 0;
         attributeDescriptions[3].location = 3;
         attributeDescriptions[3].format = VK_FORMAT_R32_SINT;
-        attributeDescriptions[3].offset = offsetof(Vertex, interaction);
+        attributeDescriptions[3].offset = offsetof(SpriteInstance, texIndex);
+
+        attributeDescriptions[4].binding = 0;
+        attributeDescriptions[4].location = 4;
+        attributeDescriptions[4].format = VK_FORMAT_R32_SINT;
+        attributeDescriptions[4].offset = offsetof(SpriteInstance, interaction);
 
         return attributeDescriptions;
     }
+};
 
-    bool operator==(const Vertex& other) const {
-        return pos == other.pos && texCoord == other.texCoord && texIndex == other.texIndex && other.interaction == other.interaction;
-    }
+// contiguous run of elements (vertices or sprite instances) written during a remap
+struct VertexRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
 };
 
 // Used for Vulkan device selection
@@ -111,6 +213,38 @@ struct SwapChainSupportDetails {
     std::vector<VkPresentModeKHR> presentModes;
 };
 
+// main loop stages that get their own frame time histogram
+typedef enum FrameStage {
+    STAGE_EVENTS = 0,
+    STAGE_WAIT = 1,
+    STAGE_SIMULATION = 2,
+    STAGE_BUFFERS = 3,
+    STAGE_RENDER = 4,
+    STAGE_LIMITER = 5,
+    STAGE_FRAME = 6, // whole loop iteration
+    STAGE_COUNT = 7,
+} FrameStage;
+const std::array<const char*, STAGE_COUNT> FRAME_STAGE_NAMES = { "handleEvents", "waitForFrame", "stepSimulation", "updateBuffers", "renderWorld", "frameLimiter", "frame" };
+
+// GPU intervals measured with timestamp queries, each also gets a histogram
+typedef enum GpuStage {
+    GPU_STAGE_SPRITES = 0,
+    GPU_STAGE_LINES = 1,
+    GPU_STAGE_RENDER_PASS = 2, // begin to end of the render pass, clears included
+    GPU_STAGE_COUNT = 3,
+} GpuStage;
+const std::array<const char*, GPU_STAGE_COUNT> GPU_STAGE_NAMES = { "gpu sprites", "gpu lines", "gpu render pass" };
+// timestamps written per frame: before the render pass, after sprites, after lines, after the render pass
+const uint32_t GPU_TIMESTAMP_COUNT = 4;
+
+// from the SDL timestamp of the oldest input event a frame handled, another histogram each
+typedef enum InputLatency {
+    LATENCY_TO_SUBMIT = 0,
+    LATENCY_TO_PRESENT = 1, // until vkWaitForPresentKHR returns on the PresentWaiter thread, needs present_id/present_wait
+    LATENCY_COUNT = 2,
+} InputLatency;
+const std::array<const char*, LATENCY_COUNT> LATENCY_NAMES = { "input to submit", "input to present" };
+
 // for filtering sprites to be shown
 typedef enum GameScreens {
     MENU = 0,
@@ -127,6 +261,72 @@ struct KeyState {
     bool space = false;
     bool shift = false;
     bool ctrl = false;
+
+    // one bit per key, so the state can cross threads in a single atomic
+    uint32_t pack() const;
+    static KeyState unpack(uint32_t bits);
+};
+
+// what the simulation hands the renderer after a tick: every moving sprite at the start
+// and end of the tick, and when that tick ends (SDL_GetTicksNS time) for interpolation
+struct SimSnapshot {
+    std::vector<int> sprites;
+    std::vector<glm::vec2> previous;
+    std::vector<glm::vec2> current;
+    uint64_t tickEndNs = 0;
+    uint64_t tick = 0;
+};
+
+// RGBA8 pixels of one image file, decoded off the main thread and handed to Texture::create() for upload
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    // size of the picture itself, smaller than width/height once Texture::pad() put a border around it
+    int sourceWidth = 0;
+    int sourceHeight = 0;
+    // released by whatever made it (stbi_image_free for stb_image)
+    std::shared_ptr<const uint8_t> pixels{};
+};
+
+// where an image ended up in the atlas: page (the texture index the shaders see) and normalized u0, v0, u1, v1
+struct TextureRegion {
+    int page = 0;
+    glm::vec4 uvRect = { 0.f, 0.f, 1.f, 1.f };
+};
+
+// runtime options, filled in from the command line by parseArgs()
+struct EngineConfig {
+    // draw one SpriteInstance per sprite instead of 4 vertices + 6 indices
+    bool instancedSprites = false;
+    // feed the quad pipeline PackedVertex instead of Vertex (ignored when instanced)
+    bool packedVertices = false;
+    // keep sprite geometry in device local memory (written directly when resizable BAR is there, staged otherwise)
+    bool deviceLocalVertices = false;
+    // main loop rate cap, 0 = uncapped
+    double targetFps = 0.0;
+    // render into offscreen images without a window, surface or present
+    bool headless = false;
+    // stop after this many frames, 0 = run until quit
+    uint64_t frameCount = 0;
+    // benchmark: generated sprites (thousands), RNG seed and where the JSON report goes
+    int benchThousands = 0;
+    uint32_t benchSeed = 1;
+    std::string benchReport = "bench_report.json";
+    // fixed simulation rate, and how many ticks one frame may run to catch up after a hitch
+    double simTickRate = 120.0;
+    int maxSimSteps = 5;
+    // run the simulation ticks on their own thread instead of inside mainLoop()
+    bool simThread = false;
+    // record the draws into this many secondary command buffers in parallel, 0 = inline on the main thread
+    int recordThreads = 0;
+    // 1 = lowest latency, more = more CPU/GPU overlap
+    int framesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+    // starting present policy, the P key cycles it while running
+    PresentPolicy presentPolicy = PRESENT_POLICY_LOW_LATENCY;
+    // poll input after waitForFrame() instead of before it, so the simulation sees it one wait sooner
+    bool lateInput = false;
+    // decoded pixel cache, empty = always decode
+    std::string pixelCache = "pixel_cache.bin";
 };
 
 // state variables for the whole program
@@ -148,17 +348,22 @@ struct GameState {
     // time
     std::chrono::time_point<std::chrono::high_resolution_clock> programStartTime;
     float currentSimulationTime = 0.f;
-    float simulationTimeDelta = 0.f;
+    float simulationTimeDelta = 0.f; // length of one fixed tick
+    float interpolationAlpha = 0.f; // how far rendering is between the last two ticks
 
-    bool needTriangleRemap = true;
     bool needLineRemap = true;
 
-    int wireframeTextureIndex = -1;
+    TextureRegion wireframeTexture{};
 };
 
 // -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
 // General utility
 void log(const std::string& src, const std::string& msg);
+// quotes, backslashes and control characters escaped for use inside a JSON string
+std::string escapeJson(const std::string& text);
+EngineConfig parseArgs(int argc, char** argv);
+// uniform in [0, 1), mapped by hand so a seed gives the same numbers with every standard library
+float randomFloat(std::mt19937& rng);
 
 // Vulkan utility
 // debug
@@ -169,19 +374,22 @@ void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& create
 bool isDeviceSuitable(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const std::vector<const char*>& deviceExtensions);
 QueueFamilyIndices findQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
 bool checkDeviceExtensionSupport(VkPhysicalDevice physicalDevice, const std::vector<const char*>& deviceExtensions);
+bool checkInstanceExtensionSupport(const std::vector<const char*>& instanceExtensions);
 
 // SWAPCHAIN details
 SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface);
 VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, PresentPolicy policy);
+std::string getPresentModeName(VkPresentModeKHR presentMode);
 VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, SDL_Window* window);
 // Depth
 VkFormat findDepthFormat(const VkPhysicalDevice& physicalDevice);
 
 // Image shit
-VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkDevice& device);
+VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkDevice& device, uint32_t mipLevels = 1);
 void createImage(uint32_t width, uint32_t height, VkFormat format,	VkImageTiling tiling, VkImageUsageFlags usage,
-	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkDevice& device, VkPhysicalDevice& physicalDevice);
+	VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, VkDevice& device, VkPhysicalDevice& physicalDevice,
+	uint32_t mipLevels = 1);
 void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, VkDevice device, 
     VkCommandPool commandPool, VkQueue graphicsQueue);
 void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDevice device, VkCommandPool commandPool, 
@@ -189,11 +397,25 @@ void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t
 
 // BUffers/memory stuff
 uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, const VkPhysicalDevice& physicalDevice);
+std::optional<uint32_t> findResizableBarMemoryType(const VkPhysicalDevice& physicalDevice);
 void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, 
-    VkDeviceMemory& bufferMemory, const VkDevice& device, const VkPhysicalDevice& physicalDevice);
+    VkDeviceMemory& bufferMemory, const VkDevice& device, const VkPhysicalDevice& physicalDevice, std::optional<uint32_t> memoryTypeIndex = std::nullopt);
 void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkPhysicalDevice physicalDevice, VkDevice device, 
     VkCommandPool commandPool, VkQueue graphicsQueue);
 
+// quad index pattern (two triangles, 0,1,2 / 2,1,3) repeated for quadCount quads
+template <typename T>
+std::vector<T> generateQuadIndices(uint32_t quadCount) {
+    const std::array<uint32_t, 6> pattern = { 0,1,2,2,1,3 };
+    std::vector<T> indices(static_cast<size_t>(quadCount) * pattern.size());
+    for (uint32_t i = 0; i < quadCount; i++) {
+        for (size_t j = 0; j < pattern.size(); j++) {
+            indices[i * pattern.size() + j] = static_cast<T>(pattern[j] + (4 * i));
+        }
+    }
+    return indices;
+}
+
 // COMMAND BUFFERS
 VkCommandBuffer beginSingleTimeCommands(VkDevice device, VkCommandPool commandPool);
 void endSingleTimeCommands(VkCommandBuffer commandBuffer, VkDevice device, VkCommandPool commandPool, VkQueue graphicsQueue);
@@ -0,0 +1,93 @@
+#include "worker_pool.h"
+
+/*
+-----~~~~~=====<<<<<{_INITIALIZATION_}>>>>>=====~~~~~-----
+*/
+void WorkerPool::init(int threadCount) {
+	log(name_ + __func__, "starting " + std::to_string(threadCount) + " worker threads");
+
+	stopping_ = false;
+	for (int i = 0; i < threadCount; i++) {
+		threads_.emplace_back(&WorkerPool::workerLoop, this);
+	}
+}
+
+/*
+-----~~~~~=====<<<<<{_TASKS_}>>>>>=====~~~~~-----
+*/
+void WorkerPool::submit(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.push_back(std::move(task));
+	}
+	taskAvailable_.notify_one();
+}
+
+void WorkerPool::wait() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	tasksDone_.wait(lock, [this]() { return tasks_.empty() && busy_ == 0; });
+
+	if (error_ != nullptr) {
+		std::exception_ptr error = error_;
+		error_ = nullptr;
+		std::rethrow_exception(error);
+	}
+}
+
+void WorkerPool::workerLoop() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			taskAvailable_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+			if (tasks_.empty()) {
+				return;
+			}
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+			busy_++;
+		}
+
+		// an exception must not take the thread down, it is handed to wait()
+		std::exception_ptr error = nullptr;
+		try {
+			task();
+		}
+		catch (...) {
+			error = std::current_exception();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			busy_--;
+			if (error != nullptr && error_ == nullptr) {
+				error_ = error;
+			}
+			if (tasks_.empty() && busy_ == 0) {
+				tasksDone_.notify_all();
+			}
+		}
+	}
+}
+
+int WorkerPool::getThreadCount() const { return static_cast<int>(threads_.size()); }
+
+/*
+-----~~~~~=====<<<<<{_CLEANUP_}>>>>>=====~~~~~-----
+*/
+void WorkerPool::cleanup() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	taskAvailable_.notify_all();
+
+	for (std::thread& thread : threads_) {
+		thread.join();
+	}
+	threads_.clear();
+}
+
+WorkerPool::~WorkerPool() {
+	cleanup();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util.h"
+
+// fixed set of threads working through a shared task queue
+class WorkerPool {
+public:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void init(int threadCount);
+
+	// queues a task, any worker may pick it up
+	void submit(std::function<void()> task);
+	// blocks until every submitted task has finished, rethrows the first exception a task threw
+	void wait();
+
+	int getThreadCount() const;
+
+	// finishes queued tasks, then joins the threads
+	void cleanup();
+	// joinable threads left behind on an exception path would take the process down
+	~WorkerPool();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	const std::string name_ = "WorkerPool::";
+
+private:
+	// -----~~~~~=====<<<<<{_METHODS_}>>>>>=====~~~~~-----
+	void workerLoop();
+
+	// -----~~~~~=====<<<<<{_VARIABLES_}>>>>>=====~~~~~-----
+	std::vector<std::thread> threads_{};
+
+	// all guarded by mutex_
+	std::mutex mutex_;
+	std::condition_variable taskAvailable_;
+	std::condition_variable tasksDone_;
+	std::deque<std::function<void()>> tasks_{};
+	int busy_ = 0;
+	bool stopping_ = false;
+	std::exception_ptr error_ = nullptr;
+};